@@ -39,6 +39,7 @@ namespace ClassGame {
                     ImGui::Text("Game Over!");
                     ImGui::Text("Winner: %d", gameWinner);
                     if (ImGui::Button("Reset Game")) {
+                        game->cancelAI();
                         game->stopGame();
                         game->setUpBoard();
                         gameOver = false;
@@ -81,9 +82,13 @@ namespace ClassGame {
 
                 ImGui::Begin("GameWindow");
                 if (game) {
-                    if (game->gameHasAI() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
+                    if (!gameOver && game->gameHasAI() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
                     {
-                        game->updateAI();
+                        if (game->gameHasAsyncAI()) {
+                            game->updateAsyncAI();
+                        } else {
+                            game->updateAI();
+                        }
                     }
                     game->drawFrame();
                 }
@@ -0,0 +1,85 @@
+//
+// Evaluation benchmark
+// Collects positions from a shallow tree and times a full bitboard evaluation of each
+// with every backend the CPU supports, next to reading the incremental score Position
+// keeps, which is what the search pays at a leaf
+// The tree is kept small enough to stay in cache so the timings are of the evaluation
+//
+// usage: chess_bench_eval [passes]
+//
+#include "../classes/BitboardEvaluator.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/Evaluation.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+static const char* benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+static void collect(ChessEngine& engine, Position& position, int depth, std::vector<Position>& positions)
+{
+    positions.push_back(position);
+    if (depth == 0) return;
+
+    MoveList moves;
+    engine.generateAllMoves(position, position.sideToMove, moves);
+    for (const BitMove& move : moves) {
+        UndoInfo undo;
+        position.makeMove(move, undo);
+        collect(engine, position, depth - 1, positions);
+        position.unmakeMove(move, undo);
+    }
+}
+
+template <typename Func>
+static void timeEvaluations(const char* name, const std::vector<Position>& positions, int passes, Func evaluate)
+{
+    long long checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (const Position& position : positions) {
+            checksum += evaluate(position);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double evaluations = static_cast<double>(positions.size()) * passes;
+
+    std::cout << std::setw(12) << name
+        << std::setw(10) << std::fixed << std::setprecision(2) << seconds * 1e9 / evaluations << " ns/eval"
+        << "  (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const int passes = argc > 1 ? std::atoi(argv[1]) : 500;
+
+    ChessEngine engine;
+    std::vector<Position> positions;
+    for (const char* fen : benchPositions) {
+        Position position;
+        position.setFromFEN(fen);
+        collect(engine, position, 2, positions);
+    }
+    std::cout << positions.size() << " positions, " << passes << " passes" << std::endl;
+
+    timeEvaluations("incremental", positions, passes, [&](const Position& position) {
+        return engine.evaluateBoard(position);
+    });
+    for (EvalBackend backend : { EVAL_SCALAR, EVAL_SSE41, EVAL_AVX2 }) {
+        if (!evalBackendSupported(backend)) {
+            std::cout << std::setw(12) << evalBackendName(backend) << "  not supported" << std::endl;
+            continue;
+        }
+        timeEvaluations(evalBackendName(backend), positions, passes, [&](const Position& position) {
+            const EvalScores scores = evaluateBitboards(position.bitboards, backend);
+            return taperedScore(scores.middlegame, scores.endgame, scores.phase);
+        });
+    }
+    return 0;
+}
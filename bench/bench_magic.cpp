@@ -0,0 +1,285 @@
+//
+// Slider attack lookup benchmark
+// Times the shared table MagicBitboards.h builds (every square's table overlapping the
+// others) against a separate slice per square, and against 16 bit references into a list
+// of the distinct attack sets in place of the attack sets, which is a third of the size but
+// takes two loads. All of them use the same magics so only the memory layout differs, and
+// the PEXT tables are timed too where the CPU has BMI2
+// Each layout is timed on its own, with the tables in cache, and again with a random read
+// of a large buffer between lookups the way transposition table probes push them out
+// Cache misses come from the CPU's counters when the kernel lets us read them
+//
+// usage: chess_bench_magic [lookups] [buffer MB]
+//
+#include "../classes/MagicBitboards.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct Lookup {
+    int square;
+    bool rook;
+    uint64_t occupied;
+};
+
+// The old layout, each square's table in a slice of its own
+struct PlainTables {
+    std::vector<uint64_t> attacks;
+    int rookOffset[64];
+    int bishopOffset[64];
+
+    PlainTables()
+    {
+        int offset = 0;
+        for (int square = 0; square < 64; square++) {
+            rookOffset[square] = offset;
+            offset += RAttackSize[square];
+            bishopOffset[square] = offset;
+            offset += BAttackSize[square];
+        }
+        attacks.resize(offset);
+        for (int square = 0; square < 64; square++) {
+            for (int piece = 0; piece < 2; piece++) {
+                const bool rook = piece == 0;
+                const uint64_t mask = rook ? RMasks[square] : BMasks[square];
+                uint64_t subset = 0;
+                do {
+                    attacks[slot(square, rook, subset)] = sliderAttacks(square, rook, subset);
+                    subset = (subset - mask) & mask;
+                } while (subset);
+            }
+        }
+    }
+
+    size_t slot(int square, bool rook, uint64_t occupied) const
+    {
+        return rook ? rookOffset[square] + rookIndex(square, occupied) : bishopOffset[square] + bishopIndex(square, occupied);
+    }
+
+    uint64_t get(int square, bool rook, uint64_t occupied) const
+    {
+        return attacks[slot(square, rook, occupied)];
+    }
+};
+
+// The shared table with each attack set stored once and referred to by a 16 bit number
+struct RefTables {
+    std::vector<uint16_t> refs;
+    std::vector<uint64_t> list;
+
+    RefTables() : refs(SliderAttackTableSize, 0)
+    {
+        std::unordered_map<uint64_t, uint16_t> numbers;
+        list.push_back(0);
+        for (int slot = 0; slot < SliderAttackTableSize; slot++) {
+            const uint64_t attacks = SliderAttacks.attacks[slot];
+            if (attacks == 0) continue;
+            auto found = numbers.find(attacks);
+            if (found == numbers.end()) {
+                found = numbers.emplace(attacks, static_cast<uint16_t>(list.size())).first;
+                list.push_back(attacks);
+            }
+            refs[slot] = found->second;
+        }
+    }
+
+    size_t slot(int square, bool rook, uint64_t occupied) const
+    {
+        return rook ? RAttackOffset[square] + rookIndex(square, occupied) : BAttackOffset[square] + bishopIndex(square, occupied);
+    }
+
+    uint64_t get(int square, bool rook, uint64_t occupied) const
+    {
+        return list[refs[slot(square, rook, occupied)]];
+    }
+};
+
+static uint64_t sharedAttacks(int square, bool rook, uint64_t occupied)
+{
+    return rook ? getRookAttacks(square, occupied) : getBishopAttacks(square, occupied);
+}
+
+// Runs the lookups for each backend the CPU supports
+template <typename Func>
+static void forEachBackend(Func run)
+{
+    for (SliderBackend backend : { SLIDER_MAGIC, SLIDER_PEXT }) {
+        if (!setSliderBackend(backend)) {
+            std::cout << std::setw(10) << sliderBackendName(backend) << "  not supported" << std::endl;
+            continue;
+        }
+        run(backend == SLIDER_MAGIC ? "shared" : sliderBackendName(backend));
+    }
+}
+
+// Counts last level cache misses for the calling thread, reads -1 when the counter can't be opened
+class CacheMissCounter {
+public:
+    CacheMissCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if (_fd >= 0) close(_fd);
+#endif
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (_fd < 0) return;
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop()
+    {
+#ifdef __linux__
+        if (_fd < 0) return -1;
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(_fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int _fd = -1;
+};
+
+// Blockers drawn the way they fall in games, each square taken about a quarter of the time
+static std::vector<Lookup> makeLookups(int count)
+{
+    std::mt19937_64 rng(1);
+    std::vector<Lookup> lookups(count);
+    for (Lookup& lookup : lookups) {
+        lookup.square = static_cast<int>(rng() & 63);
+        lookup.rook = (rng() & 3) != 0;
+        lookup.occupied = rng() & rng();
+    }
+    return lookups;
+}
+
+template <typename Func>
+static void timeLookups(const char* name, const std::vector<Lookup>& lookups, const std::vector<uint64_t>& buffer, CacheMissCounter& counter, Func get)
+{
+    // One pass to warm up and one timed
+    uint64_t checksum = 0;
+    for (const Lookup& lookup : lookups) checksum += get(lookup.square, lookup.rook, lookup.occupied);
+
+    const size_t bufferMask = buffer.size() - 1;
+    uint64_t position = 0;
+    checksum = 0;
+    counter.start();
+    const auto start = std::chrono::steady_clock::now();
+    for (const Lookup& lookup : lookups) {
+        if (!buffer.empty()) {
+            position = position * 6364136223846793005ULL + 1442695040888963407ULL;
+            checksum += buffer[(position >> 20) & bufferMask];
+        }
+        checksum += get(lookup.square, lookup.rook, lookup.occupied);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const long long misses = counter.stop();
+
+    std::cout << std::setw(10) << name
+        << std::setw(10) << std::fixed << std::setprecision(2) << seconds * 1e9 / lookups.size() << " ns/lookup"
+        << std::setw(10) << std::setprecision(1) << lookups.size() / seconds / 1e6 << " M/s";
+    if (misses >= 0) {
+        std::cout << std::setw(10) << std::setprecision(3) << static_cast<double>(misses) / lookups.size() << " misses/lookup";
+    }
+    else {
+        std::cout << "       n/a misses/lookup";
+    }
+    std::cout << "  (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 4000000;
+    const size_t bufferMB = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+
+    const PlainTables plain;
+    const RefTables refTables;
+    const std::vector<Lookup> lookups = makeLookups(count);
+
+    // Every layout has to agree with the attacks worked out ray by ray
+    bool mismatch = false;
+    forEachBackend([&](const char* name) {
+        for (const Lookup& lookup : lookups) {
+            const uint64_t expected = sliderAttacks(lookup.square, lookup.rook, lookup.occupied);
+            if ((plain.get(lookup.square, lookup.rook, lookup.occupied) != expected || refTables.get(lookup.square, lookup.rook, lookup.occupied) != expected ||
+                 sharedAttacks(lookup.square, lookup.rook, lookup.occupied) != expected) && !mismatch) {
+                std::cout << name << " attack mismatch on square " << lookup.square << std::endl;
+                mismatch = true;
+            }
+        }
+    });
+    if (mismatch) return 1;
+
+    std::unordered_set<uintptr_t> plainLines, sharedLines, refLines;
+    for (const Lookup& lookup : lookups) {
+        plainLines.insert(reinterpret_cast<uintptr_t>(&plain.attacks[plain.slot(lookup.square, lookup.rook, lookup.occupied)]) / 64);
+        const size_t slot = refTables.slot(lookup.square, lookup.rook, lookup.occupied);
+        sharedLines.insert(reinterpret_cast<uintptr_t>(&SliderAttacks.attacks[slot]) / 64);
+        refLines.insert(reinterpret_cast<uintptr_t>(&refTables.refs[slot]) / 64);
+        refLines.insert(reinterpret_cast<uintptr_t>(&refTables.list[refTables.refs[slot]]) / 64);
+    }
+
+    std::cout << "plain  " << plain.attacks.size() * sizeof(uint64_t) / 1024 << " KB, "
+        << plainLines.size() << " cache lines touched" << std::endl;
+    std::cout << "shared " << sizeof(SliderAttacks.attacks) / 1024 << " KB, "
+        << sharedLines.size() << " cache lines touched" << std::endl;
+    std::cout << "refs   " << (refTables.refs.size() * sizeof(uint16_t) + refTables.list.size() * sizeof(uint64_t)) / 1024 << " KB, "
+        << refLines.size() << " cache lines touched, 2 loads per lookup" << std::endl;
+    std::cout << "pext   " << sizeof(SliderAttacks.pextAttacks) / 1024 << " KB" << std::endl;
+    std::cout << lookups.size() << " lookups" << std::endl;
+
+    CacheMissCounter counter;
+    const std::vector<uint64_t> none;
+    std::vector<uint64_t> buffer;
+    // Rounded down to a power of two so a mask picks the entry
+    size_t entries = 1;
+    while (entries * 2 <= bufferMB * 1024 * 1024 / sizeof(uint64_t)) entries *= 2;
+    buffer.assign(entries, 1);
+
+    std::cout << "tables in cache" << std::endl;
+    timeLookups("plain", lookups, none, counter, [&](int square, bool rook, uint64_t occupied) { return plain.get(square, rook, occupied); });
+    timeLookups("refs", lookups, none, counter, [&](int square, bool rook, uint64_t occupied) { return refTables.get(square, rook, occupied); });
+    forEachBackend([&](const char* name) { timeLookups(name, lookups, none, counter, sharedAttacks); });
+    std::cout << "with a " << entries * sizeof(uint64_t) / (1024 * 1024) << " MB buffer read between lookups" << std::endl;
+    timeLookups("buffer", lookups, buffer, counter, [](int, bool, uint64_t) { return uint64_t(0); });
+    timeLookups("plain", lookups, buffer, counter, [&](int square, bool rook, uint64_t occupied) { return plain.get(square, rook, occupied); });
+    timeLookups("refs", lookups, buffer, counter, [&](int square, bool rook, uint64_t occupied) { return refTables.get(square, rook, occupied); });
+    forEachBackend([&](const char* name) { timeLookups(name, lookups, buffer, counter, sharedAttacks); });
+    return 0;
+}
@@ -0,0 +1,105 @@
+//
+// Fixed depth search benchmark
+// Searches a few positions to the same depth on one thread and reports the nodes, time
+// and how often the first move searched caused the cutoff, so changes to move ordering
+// and pruning can be compared by the size of the tree they search
+// Then plays a few moves of a game against itself, once starting every search from
+// nothing and once keeping what the engine learned between moves, the way a game is played
+//
+// usage: chess_bench_search [depth] [--no-null] [--no-lmr] [--no-futility]
+//        the flags switch off one of the selective search features for an A/B run
+//
+#include "../classes/ChessEngine.h"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+static const char* benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+int main(int argc, char** argv)
+{
+    int depth = 6;
+    SearchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--no-null") == 0) options.nullMovePruning = false;
+        else if (std::strcmp(argv[i], "--no-lmr") == 0) options.lateMoveReductions = false;
+        else if (std::strcmp(argv[i], "--no-futility") == 0) options.futilityPruning = false;
+        else depth = std::atoi(argv[i]);
+    }
+
+    ChessEngine engine;
+    engine.setHashSize(64);
+    engine.setThreadCount(1);
+    engine.setSearchOptions(options);
+
+    SearchLimits limits;
+    limits.maxDepth = depth;
+
+    long long totalNodes = 0;
+    double totalSeconds = 0.0;
+    long long totalCutoffs = 0;
+    long long totalFirstMoveCutoffs = 0;
+
+    std::cout << "depth " << depth
+        << (options.nullMovePruning ? "" : ", no null move")
+        << (options.lateMoveReductions ? "" : ", no LMR")
+        << (options.futilityPruning ? "" : ", no futility") << std::endl;
+    std::cout << "        nodes    time  first move cutoffs  best move  score" << std::endl;
+    for (const char* fen : benchPositions) {
+        Position position;
+        position.setFromFEN(fen);
+        engine.newGame(); // each position on its own
+        SearchResult result = engine.search(position, limits);
+
+        totalNodes += result.nodes;
+        totalSeconds += result.seconds;
+        totalCutoffs += result.betaCutoffs;
+        totalFirstMoveCutoffs += result.firstMoveCutoffs;
+
+        const double firstMoveRate = result.betaCutoffs > 0 ? 100.0 * result.firstMoveCutoffs / result.betaCutoffs : 0.0;
+        std::cout << std::setw(13) << result.nodes
+            << std::setw(7) << std::fixed << std::setprecision(2) << result.seconds << "s"
+            << std::setw(19) << std::setprecision(1) << firstMoveRate << "%"
+            << std::setw(11) << moveToString(result.bestMove)
+            << std::setw(7) << result.score << std::endl;
+    }
+
+    const double firstMoveRate = totalCutoffs > 0 ? 100.0 * totalFirstMoveCutoffs / totalCutoffs : 0.0;
+    std::cout << "total " << totalNodes << " nodes in " << std::setprecision(2) << totalSeconds << "s, "
+        << std::setprecision(0) << (totalSeconds > 0.0 ? totalNodes / totalSeconds : 0.0) << " nodes/s, "
+        << std::setprecision(1) << firstMoveRate << "% of cutoffs on the first move" << std::endl;
+
+    // The same game both times, the reusing run is checked against the moves of the first
+    constexpr int gameMoves = 12;
+    std::vector<BitMove> game;
+    for (bool reuse : { false, true }) {
+        Position position;
+        position.setFromFEN(benchPositions[0]);
+        engine.newGame();
+
+        long long nodes = 0;
+        double seconds = 0.0;
+        for (int ply = 0; ply < gameMoves; ply++) {
+            if (!reuse) engine.newGame();
+            const SearchResult result = engine.search(position, limits);
+            if (result.bestMove.isNone()) break;
+            nodes += result.nodes;
+            seconds += result.seconds;
+
+            if (!reuse) game.push_back(result.bestMove);
+            UndoInfo undo;
+            position.makeMove(game[ply], undo);
+        }
+        std::cout << (reuse ? "game, kept between moves  " : "game, cleared every move  ")
+            << std::setw(10) << nodes << " nodes in " << std::setprecision(2) << seconds << "s" << std::endl;
+    }
+    return 0;
+}
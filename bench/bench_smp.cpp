@@ -0,0 +1,78 @@
+//
+// Parallel search scaling benchmark
+// Searches a few positions for a fixed time with 1, 2, 4... threads and reports nodes/s
+// and the speedup over one thread, along with the depth the main thread reached
+//
+// usage: chess_bench_smp [milliseconds per search] [max threads] [lazy|split]
+//
+#include "../classes/ChessEngine.h"
+#include <cstdlib>
+#include <iomanip>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w",
+};
+
+int main(int argc, char** argv)
+{
+    const int timeLimit = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (maxThreads < 1) maxThreads = 1;
+    const bool rootSplit = argc > 3 && std::strcmp(argv[3], "split") == 0;
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    ChessEngine engine;
+    engine.setHashSize(64);
+    engine.setSearchMode(rootSplit ? SEARCH_ROOT_SPLIT : SEARCH_LAZY_SMP);
+
+    SearchLimits limits;
+    limits.timeLimit = timeLimit;
+
+    std::cout << (rootSplit ? "root split" : "lazy smp") << std::endl;
+    std::cout << "threads      nodes/s  speedup  avg depth" << std::endl;
+
+    double baseNodesPerSecond = 0.0;
+    for (int threads : threadCounts) {
+        engine.setThreadCount(threads);
+
+        long long nodes = 0;
+        double seconds = 0.0;
+        int depth = 0;
+        for (const char* fen : benchPositions) {
+            Position position;
+            position.setFromFEN(fen);
+            engine.newGame();
+            SearchResult result = engine.search(position, limits);
+            nodes += result.nodes;
+            seconds += result.seconds;
+            depth += result.depth;
+        }
+
+        const double nodesPerSecond = seconds > 0.0 ? nodes / seconds : 0.0;
+        if (threads == 1) {
+            baseNodesPerSecond = nodesPerSecond;
+        }
+        const double speedup = baseNodesPerSecond > 0.0 ? nodesPerSecond / baseNodesPerSecond : 0.0;
+        const double avgDepth = static_cast<double>(depth) / (sizeof(benchPositions) / sizeof(benchPositions[0]));
+
+        std::cout << std::setw(7) << threads
+            << std::setw(13) << std::fixed << std::setprecision(0) << nodesPerSecond
+            << std::setw(8) << std::setprecision(2) << speedup << "x"
+            << std::setw(11) << std::setprecision(1) << avgDepth << std::endl;
+    }
+
+    return 0;
+}
@@ -99,19 +99,44 @@ private:
 
 };
 
+// What kind of move a BitMove is, the capture bit (4) and promotion bit (8) can be
+// tested on their own, and a promotion's low two bits pick the piece
+enum MoveFlag
+{
+    QUIET_MOVE,
+    DOUBLE_PAWN_PUSH,
+    KING_CASTLE,
+    QUEEN_CASTLE,
+    CAPTURE,
+    EN_PASSANT,
+    PROMOTION = 8,          // plus 0 knight, 1 bishop, 2 rook, 3 queen
+    PROMOTION_CAPTURE = 12
+};
+
+// A move packed in 16 bits: from square in bits 0-5, to square in 6-11 and a MoveFlag
+// in 12-15. The piece moved and the piece taken are on the board, see Position
 struct BitMove {
-    uint8_t from;
-    uint8_t to;
-    uint8_t piece;
-    
-    BitMove(int from, int to, ChessPiece piece)
-        : from(from), to(to), piece(piece) { }
-        
-    BitMove() : from(0), to(0), piece(NoPiece) { }
-    
-    bool operator==(const BitMove& other) const {
-        return from == other.from && 
-               to == other.to && 
-               piece == other.piece;
-    }
+    uint16_t data;
+
+    BitMove(int from, int to, int flags = QUIET_MOVE)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) { }
+
+    // a1 to a1, never a real move
+    BitMove() : data(0) { }
+
+    int from() const { return data & 63; }
+    int to() const { return (data >> 6) & 63; }
+    int flags() const { return data >> 12; }
+
+    bool isNone() const { return data == 0; }
+    bool isCapture() const { return (flags() & CAPTURE) != 0; }
+    bool isPromotion() const { return (flags() & PROMOTION) != 0; }
+    bool isEnPassant() const { return flags() == EN_PASSANT; }
+    bool isCastle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+    bool isDoublePawnPush() const { return flags() == DOUBLE_PAWN_PUSH; }
+
+    // Piece a pawn turns into on the last rank, NoPiece otherwise
+    ChessPiece promotion() const { return isPromotion() ? static_cast<ChessPiece>(Knight + (flags() & 3)) : NoPiece; }
+
+    bool operator==(const BitMove& other) const { return data == other.data; }
 };
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "BitboardEvaluator.h"
+#include "Evaluation.h"
+#include <bit>
+
+// The vector backends are built with per function target attributes so the rest of the
+// engine doesn't need AVX2 to run, other compilers and CPUs get the scalar backend
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define EVAL_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Piece square scores without the material, which is counted separately by popcount
+// They fit easily in 16 bits, so a vector covers twice as many squares, and the rows are
+// aligned so any sixteen squares starting on an even rank load as one AVX2 vector
+struct alignas(32) PieceSquareScores {
+    int16_t middlegame[12][64];
+    int16_t endgame[12][64];
+};
+
+constexpr PieceSquareScores buildPieceSquareScores()
+{
+    PieceSquareScores scores{};
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            scores.middlegame[piece][square] = static_cast<int16_t>(evalTables.middlegame[piece][square] - pieceValues[piece]);
+            scores.endgame[piece][square] = static_cast<int16_t>(evalTables.endgame[piece][square] - pieceValues[piece]);
+        }
+    }
+    return scores;
+}
+
+static constexpr PieceSquareScores pieceSquareScores = buildPieceSquareScores();
+
+static inline void addMaterial(EvalScores& scores, int piece, uint64_t bits)
+{
+    const int count = std::popcount(bits);
+    scores.middlegame += count * pieceValues[piece];
+    scores.endgame += count * pieceValues[piece];
+    scores.phase += count * phaseWeights[piece];
+}
+
+static EvalScores evaluateScalar(const BitboardElement* bitboards)
+{
+    EvalScores scores{ 0, 0, 0 };
+    for (int piece = 0; piece < 12; piece++) {
+        addMaterial(scores, piece, bitboards[piece].getData());
+        bitboards[piece].forEachBit([&](int square) {
+            scores.middlegame += pieceSquareScores.middlegame[piece][square];
+            scores.endgame += pieceSquareScores.endgame[piece][square];
+        });
+    }
+    return scores;
+}
+
+#ifdef EVAL_X86_SIMD
+
+// Each 16 bit lane of a vector holds one square, a lane is kept when its bit in the
+// bitboard is set and the kept lanes are added up across every piece before one
+// horizontal sum at the end
+// A square only ever holds one piece, so a lane adds at most one score for each chunk
+// of the board and can't overflow, and most chunks of a piece's board are empty so
+// those are skipped
+
+__attribute__((target("sse4.1")))
+static inline int horizontalSum(__m128i sum)
+{
+    sum = _mm_madd_epi16(sum, _mm_set1_epi16(1)); // pairs of 16 bit lanes into 32 bits
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_extract_epi32(sum, 0);
+}
+
+__attribute__((target("sse4.1,popcnt")))
+static EvalScores evaluateSSE41(const BitboardElement* bitboards)
+{
+    const __m128i lanes = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+    __m128i middlegame = _mm_setzero_si128();
+    __m128i endgame = _mm_setzero_si128();
+
+    EvalScores scores{ 0, 0, 0 };
+    for (int piece = 0; piece < 12; piece++) {
+        const uint64_t bits = bitboards[piece].getData();
+        if (bits == 0) continue;
+        addMaterial(scores, piece, bits);
+
+        for (int first = 0; first < 64; first += 8) {
+            const short rank = static_cast<short>((bits >> first) & 0xFF);
+            if (rank == 0) continue;
+            const __m128i mask = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(rank), lanes), lanes);
+            const __m128i mg = _mm_load_si128(reinterpret_cast<const __m128i*>(&pieceSquareScores.middlegame[piece][first]));
+            const __m128i eg = _mm_load_si128(reinterpret_cast<const __m128i*>(&pieceSquareScores.endgame[piece][first]));
+            middlegame = _mm_add_epi16(middlegame, _mm_and_si128(mask, mg));
+            endgame = _mm_add_epi16(endgame, _mm_and_si128(mask, eg));
+        }
+    }
+    scores.middlegame += horizontalSum(middlegame);
+    scores.endgame += horizontalSum(endgame);
+    return scores;
+}
+
+__attribute__((target("avx2")))
+static inline int horizontalSum(__m256i sum)
+{
+    // Sign extend both halves before adding them so the 16 bit lanes still can't overflow
+    const __m256i low = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(sum));
+    const __m256i high = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(sum, 1));
+    const __m256i wide = _mm256_add_epi32(low, high);
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(wide), _mm256_extracti128_si256(wide, 1));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(total);
+}
+
+__attribute__((target("avx2,popcnt")))
+static EvalScores evaluateAVX2(const BitboardElement* bitboards)
+{
+    const __m256i lanes = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128,
+        256, 512, 1024, 2048, 4096, 8192, 16384, static_cast<short>(0x8000));
+    __m256i middlegame = _mm256_setzero_si256();
+    __m256i endgame = _mm256_setzero_si256();
+
+    EvalScores scores{ 0, 0, 0 };
+    for (int piece = 0; piece < 12; piece++) {
+        const uint64_t bits = bitboards[piece].getData();
+        if (bits == 0) continue;
+        addMaterial(scores, piece, bits);
+
+        for (int first = 0; first < 64; first += 16) {
+            const short ranks = static_cast<short>((bits >> first) & 0xFFFF);
+            if (ranks == 0) continue;
+            const __m256i mask = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16(ranks), lanes), lanes);
+            const __m256i mg = _mm256_load_si256(reinterpret_cast<const __m256i*>(&pieceSquareScores.middlegame[piece][first]));
+            const __m256i eg = _mm256_load_si256(reinterpret_cast<const __m256i*>(&pieceSquareScores.endgame[piece][first]));
+            middlegame = _mm256_add_epi16(middlegame, _mm256_and_si256(mask, mg));
+            endgame = _mm256_add_epi16(endgame, _mm256_and_si256(mask, eg));
+        }
+    }
+    scores.middlegame += horizontalSum(middlegame);
+    scores.endgame += horizontalSum(endgame);
+    return scores;
+}
+
+#endif
+
+bool evalBackendSupported(EvalBackend backend)
+{
+    switch (backend) {
+    case EVAL_SCALAR:
+    case EVAL_BEST:
+        return true;
+#ifdef EVAL_X86_SIMD
+    // Can run before main when a Position is a global, so make sure the CPU info is filled in
+    case EVAL_SSE41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt");
+    case EVAL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* evalBackendName(EvalBackend backend)
+{
+    switch (backend) {
+    case EVAL_SCALAR: return "scalar";
+    case EVAL_SSE41: return "sse4.1";
+    case EVAL_AVX2: return "avx2";
+    default: return "best";
+    }
+}
+
+using EvalFunction = EvalScores (*)(const BitboardElement*);
+
+static EvalFunction backendFunction(EvalBackend backend)
+{
+#ifdef EVAL_X86_SIMD
+    // Eight squares at a time with a branch for each rank isn't reliably faster than walking
+    // the set bits, so SSE4.1 is only used when asked for
+    if (backend == EVAL_BEST) {
+        backend = evalBackendSupported(EVAL_AVX2) ? EVAL_AVX2 : EVAL_SCALAR;
+    }
+    if (backend == EVAL_AVX2 && evalBackendSupported(EVAL_AVX2)) return evaluateAVX2;
+    if (backend == EVAL_SSE41 && evalBackendSupported(EVAL_SSE41)) return evaluateSSE41;
+#endif
+    return evaluateScalar;
+}
+
+EvalScores evaluateBitboards(const BitboardElement* bitboards, EvalBackend backend)
+{
+    // The CPU doesn't change, so only ask it once
+    static const EvalFunction functions[] = {
+        backendFunction(EVAL_SCALAR), backendFunction(EVAL_SSE41), backendFunction(EVAL_AVX2), backendFunction(EVAL_BEST)
+    };
+    return functions[backend](bitboards);
+}
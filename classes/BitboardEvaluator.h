@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Bitboard.h"
+
+//
+// Full evaluation straight from the 12 piece bitboards, for when there is no running
+// score to lean on: setting up a position, testing and scoring positions in bulk
+// Material and phase come from popcounts and the piece square scores are summed sixteen
+// (AVX2) or eight (SSE4.1) squares at a time. By default it's AVX2 where the CPU has it
+// and the scalar loop everywhere else, SSE4.1 only when asked for
+// Every backend gives exactly the same numbers Position keeps up to date in makeMove
+//
+
+struct EvalScores {
+    int middlegame;
+    int endgame;
+    int phase;
+};
+
+enum EvalBackend
+{
+    EVAL_SCALAR,
+    EVAL_SSE41,
+    EVAL_AVX2,
+    EVAL_BEST // AVX2 if the CPU has it, otherwise scalar
+};
+
+// bitboards is in BitboardIndex order, only the 12 piece boards are read
+EvalScores evaluateBitboards(const BitboardElement* bitboards, EvalBackend backend = EVAL_BEST);
+
+// Whether the backend was compiled in and the CPU can run it
+bool evalBackendSupported(EvalBackend backend);
+const char* evalBackendName(EvalBackend backend);
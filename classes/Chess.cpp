@@ -1,6 +1,4 @@
 #include "Chess.h"
-#include "PieceSquare.h"
-#include "MagicBitboards.h"
 #include <limits>
 #include <cmath>
 #include <map>
@@ -12,56 +10,12 @@ Chess::Chess()
 {
     _grid = new Grid(8, 8);
 
-    initMagicBitboards();
-
-    for (int i = 0; i < 128; i++) { _bitboardLookup[i] = 0; }
-
-    _bitboardLookup['P'] = WHITE_PAWNS;
-    _bitboardLookup['N'] = WHITE_KNIGHTS;
-    _bitboardLookup['B'] = WHITE_BISHOPS;
-    _bitboardLookup['R'] = WHITE_ROOKS;
-    _bitboardLookup['Q'] = WHITE_QUEENS;
-    _bitboardLookup['K'] = WHITE_KING;
-    _bitboardLookup['p'] = BLACK_PAWNS;
-    _bitboardLookup['n'] = BLACK_KNIGHTS;
-    _bitboardLookup['b'] = BLACK_BISHOPS;
-    _bitboardLookup['r'] = BLACK_ROOKS;
-    _bitboardLookup['q'] = BLACK_QUEENS;
-    _bitboardLookup['k'] = BLACK_KING;
-    _bitboardLookup['0'] = EMPTY_SQUARES;
-
-    _evaluateScores['P'] = 100;
-    _evaluateScores['N'] = 300;
-    _evaluateScores['B'] = 400;
-    _evaluateScores['R'] = 500;
-    _evaluateScores['Q'] = 900;
-    _evaluateScores['K'] = 2000;
-    _evaluateScores['p'] = -100;
-    _evaluateScores['n'] = -300;
-    _evaluateScores['b'] = -400;
-    _evaluateScores['r'] = -500;
-    _evaluateScores['q'] = -900;
-    _evaluateScores['k'] = -2000;
-    _evaluateScores['0'] = 0;
-
-    _pieceSquareTables['P'] = pawnTableWhite;
-    _pieceSquareTables['N'] = knightTableWhite;
-    _pieceSquareTables['B'] = bishopTableWhite;
-    _pieceSquareTables['R'] = rookTableWhite;
-    _pieceSquareTables['Q'] = queenTableWhite;
-    _pieceSquareTables['K'] = kingTableWhite;
-    _pieceSquareTables['p'] = pawnTableBlack;
-    _pieceSquareTables['n'] = knightTableBlack;
-    _pieceSquareTables['b'] = bishopTableBlack;
-    _pieceSquareTables['r'] = rookTableBlack;
-    _pieceSquareTables['q'] = queenTableBlack;
-    _pieceSquareTables['k'] = kingTableBlack;
-    _pieceSquareTables['0'] = emptyTable;
+    _gameOptions.AITimeLimit = AI_TIME_LIMIT_MS;
 }
 
 Chess::~Chess()
 {
-    cleanupMagicBitboards();
+    cancelAI();
     delete _grid;
 }
 
@@ -102,11 +56,10 @@ void Chess::setUpBoard()
     _gameOptions.rowY = 8;
 
     _grid->initializeChessSquares(pieceSize, "boardsquare.png");
-    FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
-    // FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    _engine.newGame();
 
-    std::string state = stateString();
-    _moves = generateAllMoves(state, getCurrentPlayer()->playerNumber());
+    _engine.generateAllMoves(_position, _position.sideToMove, _moves);
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -119,8 +72,7 @@ void Chess::FENtoBoard(const std::string& fen) {
     // convert a FEN string to a board
     // FEN is a space delimited string with 6 fields
     // 1: piece placement (from white's perspective)
-    // NOT PART OF THIS ASSIGNMENT BUT OTHER THINGS THAT CAN BE IN A FEN STRING
-    // ARE BELOW
+    // The grid only shows the pieces, the rest of the fields go into _position
     // 2: active color (W or B)
     // 3: castling availability (KQkq or -)
     // 4: en passant target square (in algebraic notation, or -)
@@ -185,6 +137,9 @@ void Chess::FENtoBoard(const std::string& fen) {
             }
         }
     }
+
+    _position.setFromFEN(fen);
+    _history.clear();
 }
 
 bool Chess::actionForEmptyHolder(BitHolder &holder)
@@ -205,9 +160,9 @@ bool Chess::canBitMoveFrom(Bit &bit, BitHolder &src)
     if (square) {
         int squareIndex = square->getSquareIndex();
         for (auto move : _moves) {
-            if (move.from == squareIndex) {
+            if (move.from() == squareIndex) {
                 ret = true;
-                auto dest = _grid->getSquareByIndex(move.to);
+                auto dest = _grid->getSquareByIndex(move.to());
                 dest->setHighlighted(true);
             }
         }
@@ -226,7 +181,7 @@ bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
         int dstIndex = dstSquare->getSquareIndex();
         
         for (auto move : _moves) {
-            if (move.to == dstIndex && move.from == srcIndex) {
+            if (move.to() == dstIndex && move.from() == srcIndex) {
                 return true;
             }
         }
@@ -237,6 +192,8 @@ bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 
 void Chess::stopGame()
 {
+    cancelAI();
+    _engine.newGame();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -255,22 +212,83 @@ Player* Chess::ownerAt(int x, int y) const
     return square->bit()->getOwner();
 }
 
+// Both are called from endTurn once _moves holds the replies to the move just made
+// Checkmate, the side that just moved wins
 Player* Chess::checkForWinner()
 {
+    if (_moves.empty() && _engine.inCheck(_position)) {
+        return getPlayerAt(_position.sideToMove ^ 1);
+    }
     return nullptr;
 }
 
+// Stalemate, threefold repetition or fifty moves each without a capture or pawn move
 bool Chess::checkForDraw()
 {
-    return false;
+    if (_moves.empty()) {
+        return !_engine.inCheck(_position);
+    }
+    return _position.halfmoveClock >= 100 ||
+        isRepetition(_position, _history.data(), static_cast<int>(_history.size()));
 }
 
 // Overriding this function to allow for regeneration of moves
 void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 {
+    ChessSquare* srcSquare = (ChessSquare *) &src;
+    ChessSquare* dstSquare = (ChessSquare *) &dst;
+
+    BitMove move;
+    if (findMove(srcSquare->getSquareIndex(), dstSquare->getSquareIndex(), move)) {
+        updateGridForMove(move);
+
+        _history.push_back(_position.hash);
+        UndoInfo undo;
+        _position.makeMove(move, undo);
+    }
+
+    _engine.generateAllMoves(_position, _position.sideToMove, _moves);
     endTurn();
-    std::string state = stateString();
-    _moves = generateAllMoves(state, getCurrentPlayer()->playerNumber());
+}
+
+// The GUI only knows which squares a piece was dragged between, so look the move up in
+// the legal moves, a pawn reaching the last rank becomes _promotionPiece
+bool Chess::findMove(int from, int to, BitMove& move) const
+{
+    for (auto candidate : _moves) {
+        if (candidate.from() == from && candidate.to() == to &&
+            (!candidate.isPromotion() || candidate.promotion() == _promotionPiece)) {
+            move = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The piece itself has already been dropped on its square, this does the rest of the move
+// before _position makes it: the rook of a castle, the pawn taken en passant and promotion
+void Chess::updateGridForMove(const BitMove& move)
+{
+    if (move.isCastle()) {
+        ChessSquare* rookSrc = _grid->getSquareByIndex(move.flags() == KING_CASTLE ? move.from() + 3 : move.from() - 4);
+        ChessSquare* rookDst = _grid->getSquareByIndex((move.from() + move.to()) / 2);
+        Bit* rook = rookSrc->bit();
+        if (rook) {
+            rookDst->dropBitAtPoint(rook, ImVec2(0, 0));
+            rookSrc->setBit(nullptr);
+        }
+    }
+
+    if (move.isEnPassant()) {
+        _grid->getSquareByIndex(move.to() ^ 8)->destroyBit();
+    }
+
+    if (move.isPromotion()) {
+        ChessSquare* square = _grid->getSquareByIndex(move.to());
+        Bit* promoted = PieceForPlayer(_position.sideToMove, move.promotion());
+        promoted->setPosition(square->getPosition());
+        square->setBit(promoted);
+    }
 }
 
 void Chess::clearBoardHighlights()
@@ -308,246 +326,68 @@ void Chess::setStateString(const std::string &s)
     });
 }
 
-std::vector<BitMove> Chess::generateAllMoves(std::string& state, int playerColor)
+//
+// synchronous version of the AI turn, the GUI uses updateAsyncAI instead so it doesn't block
+//
+void Chess::updateAI()
 {
-    playerColor = (playerColor + 1) >> 1; // Converts -1 to 0 for when AI calls this function
-
-    std::vector<BitMove> moves;
-    moves.reserve(32);
-
-    for (int i = 0; i < e_numBitboards; i++) {
-        _bitboards[i] = 0;
-    }
-
-    for (int i = 0; i < 64; i++) {
-        _bitboards[_bitboardLookup[state[i]]] |= 1ULL << i;
+    prepareAISearch();
+    AIMove move = searchAIMove();
+    if (move.from >= 0) {
+        applyAIMove(move);
     }
-
-    _bitboards[WHITE_ALL_PIECES] = _bitboards[WHITE_PAWNS] |
-        _bitboards[WHITE_KNIGHTS] |
-        _bitboards[WHITE_BISHOPS] |
-        _bitboards[WHITE_ROOKS] |
-        _bitboards[WHITE_QUEENS] |
-        _bitboards[WHITE_KING];
-
-    _bitboards[BLACK_ALL_PIECES] = _bitboards[BLACK_PAWNS] |
-        _bitboards[BLACK_KNIGHTS] |
-        _bitboards[BLACK_BISHOPS] |
-        _bitboards[BLACK_ROOKS] |
-        _bitboards[BLACK_QUEENS] |
-        _bitboards[BLACK_KING];
-
-    _bitboards[OCCUPANCY] = _bitboards[WHITE_ALL_PIECES] | _bitboards[BLACK_ALL_PIECES];
-    _bitboards[EMPTY_SQUARES] = ~_bitboards[OCCUPANCY];
-    
-    generateKnightMoves(moves, _bitboards[WHITE_KNIGHTS + playerColor], ~_bitboards[WHITE_ALL_PIECES + playerColor]);
-    generatePawnMoves(moves, _bitboards[WHITE_PAWNS + playerColor], _bitboards[EMPTY_SQUARES], _bitboards[BLACK_ALL_PIECES - playerColor], playerColor);
-    generateKingMoves(moves, _bitboards[WHITE_KING + playerColor], ~_bitboards[WHITE_ALL_PIECES + playerColor]);
-    generateBishopMoves(moves, _bitboards[WHITE_BISHOPS + playerColor], _bitboards[OCCUPANCY], _bitboards[WHITE_ALL_PIECES + playerColor]);
-    generateRookMoves(moves, _bitboards[WHITE_ROOKS + playerColor], _bitboards[OCCUPANCY], _bitboards[WHITE_ALL_PIECES + playerColor]);
-    generateQueenMoves(moves, _bitboards[WHITE_QUEENS + playerColor], _bitboards[OCCUPANCY], _bitboards[WHITE_ALL_PIECES + playerColor]);
-
-    return moves;
-}
-
-// Generate actual move objects from a bitboard
-void Chess::generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, BitboardElement emptySquares) {
-    knightBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(KnightAttacks[fromSquare] & (emptySquares.getData()));
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Knight);
-        });
-    });
 }
 
-void Chess::generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, BitboardElement emptySquares)
+void Chess::prepareAISearch()
 {
-    kingBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(KingAttacks[fromSquare] & (emptySquares.getData()));
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, King);
-        });
-    });
+    _searchPosition = _position;
+    _searchHistory = _history;
+
+    // Copy the limits too so the search thread never reads _gameOptions
+    _searchLimits.maxDepth = _gameOptions.AIMAXDepth > 0 ? std::min(_gameOptions.AIMAXDepth, MAX_DEPTH) : MAX_DEPTH;
+    _searchLimits.timeLimit = _gameOptions.AITimeLimit;
+    _searchLimits.nodeLimit = _gameOptions.AINodeLimit;
+    _searchLimits.cancel = &_aiCancel;
+    _engine.setThreadCount(_gameOptions.AIThreads);
 }
 
-void Chess::generateBishopMoves(std::vector<BitMove>& moves, BitboardElement piecesBoard, BitboardElement occupancy, BitboardElement friendlies)
+void Chess::applyAIMove(const AIMove& move)
 {
-    piecesBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(getBishopAttacks(fromSquare, occupancy.getData()) & ~friendlies.getData());
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Bishop);
-        });
-    });
-}
+    _gameOptions.AIDepthSearches = _searchResult.depth;
 
-void Chess::generateRookMoves(std::vector<BitMove>& moves, BitboardElement piecesBoard, BitboardElement occupancy, BitboardElement friendlies)
-{
-    piecesBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(getRookAttacks(fromSquare, occupancy.getData()) & ~friendlies.getData());
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Rook);
-        });
-    });
-}
-
-void Chess::generateQueenMoves(std::vector<BitMove>& moves, BitboardElement piecesBoard, BitboardElement occupancy, BitboardElement friendlies)
-{
-    piecesBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(getQueenAttacks(fromSquare, occupancy.getData()) & ~friendlies.getData());
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Queen);
-        });
-    });
-}
-
-void Chess::generatePawnMoves(std::vector<BitMove> &moves, BitboardElement pawnsBoard, BitboardElement emptySquares, BitboardElement enemySquares, int color)
-{
-    if (!pawnsBoard.getData()) return;
-
-    // Find all single moves, move pawns up or down depending on the color
-    BitboardElement singleMoves = (color == WHITE) ? (pawnsBoard.getData() << 8) & emptySquares.getData() : (pawnsBoard.getData() >> 8) & emptySquares.getData();
-
-    // Find all double moves, move pawns an extra space forward if they are in the right rank
-    BitboardElement doubleMoves = (color == WHITE) ? ((singleMoves.getData() & Rank3) << 8) & emptySquares.getData() : ((singleMoves.getData() & Rank6) >> 8) & emptySquares.getData();
-
-    // Captures
-    BitboardElement capturesLeft = (color == WHITE) ? ((pawnsBoard.getData() & NotAFile) << 7) & enemySquares.getData() : ((pawnsBoard.getData() & NotAFile) >> 9) & enemySquares.getData();
-    BitboardElement capturesRight = (color == WHITE) ? ((pawnsBoard.getData() & NotHFile) << 9) & enemySquares.getData() : ((pawnsBoard.getData() & NotHFile) >> 7) & enemySquares.getData();
-
-    // Store shifts in ints so that we can add moves
-    int singleShift = (color == WHITE) ? 8 : -8;
-    int doubleShift = (color == WHITE) ? 16 : -16;
-    int captureLeftShift = (color == WHITE) ? 7 : -9;
-    int captureRightShift = (color == WHITE) ? 9 : -7;
-
-    addPawnBitboardMovesToList(moves, singleMoves, singleShift);
-    addPawnBitboardMovesToList(moves, doubleMoves, doubleShift);
-    addPawnBitboardMovesToList(moves, capturesLeft, captureLeftShift);
-    addPawnBitboardMovesToList(moves, capturesRight, captureRightShift);
-}
-
-void Chess::addPawnBitboardMovesToList(std::vector<BitMove> &moves, const BitboardElement board, int shift)
-{
-    if (!board.getData()) return;
-
-    board.forEachBit([&](int toSquare) {
-        int fromSquare = toSquare - shift;
-        moves.emplace_back(fromSquare, toSquare, Pawn);
-    });
+    // AIMove only has the squares, so pass the promotion the search chose along
+    if (_searchResult.bestMove.isPromotion()) {
+        _promotionPiece = _searchResult.bestMove.promotion();
+    }
+    Game::applyAIMove(move);
+    _promotionPiece = Queen;
 }
 
 //
-// this is the function that will be called by the AI
+// this is the function that will be called by the AI, on the search thread
 //
-void Chess::updateAI()
-{
-    int bestVal = negInfinite;
-    BitMove bestMove;
-    std::string state = stateString();
-
-    // Set time and move tracking variables
-    const auto searchStart = std::chrono::steady_clock::now();
-    _countMoves = 0;
-
-    for (auto move : _moves) {
-
-        // Save previous state
-        char oldDestination = state[move.to];
-        char pieceMoving = state[move.from];
-
-        // Make the move
-        state[move.to] = pieceMoving;
-        state[move.from] = '0';
-
-
-        int moveVal = -negamax(state, MAX_DEPTH, negInfinite, posInfinite, HUMAN_PLAYER);
-
-        // Undo the move
-        state[move.to] = oldDestination;
-        state[move.from] = pieceMoving;
-        
-        // If the value of the current move is more than the best value, update best
-        if (moveVal > bestVal) {
-            bestMove = move;
-            bestVal = moveVal;
-        }
-    }
-
-    if (bestVal != negInfinite) {
-        // Calculate and print out boards per second
-        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - searchStart).count();
-        const double boardsPerSecond = seconds > 0.0 ? static_cast<double>(_countMoves) / seconds : 0.0;
-        std::cout << "Moves checked: " << _countMoves << " (" << std::fixed << std::setprecision(2) << boardsPerSecond << " boards/s)" 
-            << std::defaultfloat << " MAX DEPTH = " << MAX_DEPTH << std::endl;
-        // Make best move
-        int srcSquare = bestMove.from;
-        int dstSquare = bestMove.to;
-        BitHolder& src = getHolderAt(srcSquare&7, srcSquare/8);
-        BitHolder& dst = getHolderAt(dstSquare&7, dstSquare/8);
-        Bit* bit = src.bit();
-        dst.dropBitAtPoint(bit, ImVec2(0, 0));
-        src.setBit(nullptr);
-        bitMovedFromTo(*bit, src, dst);
-    }
-}
-
-int Chess::negamax(std::string& state, int depth, int alpha, int beta, int playerColor)
+AIMove Chess::searchAIMove()
 {
-    _countMoves++;
-
-    // Base case
-    if (depth == 0) {
-        // Multiply by negative player color because evaluate function evaluates for white
-        return evaluateBoard(state) * -playerColor;
-    }
-
-    // Generate moves for this board state
-    auto newMoves = generateAllMoves(state, playerColor);
-
-    int bestVal = negInfinite; // Min value
-    
-    for (auto move : newMoves) {
-
-        // Save previous state
-        char oldDestination = state[move.to];
-        char pieceMoving = state[move.from];
-
-        // Make the move
-        state[move.to] = pieceMoving;
-        state[move.from] = '0';
-
-        // Recursively evaluate (note the negation and flipped player color)
-        bestVal = std::max(bestVal, -negamax(state, depth - 1, -beta, -alpha, -playerColor));
-
-        // Undo the move
-        state[move.to] = oldDestination;
-        state[move.from] = pieceMoving;
-
-        // Alpha-beta pruning
-        alpha = std::max(alpha, bestVal);
-
-        if (alpha >= beta) {
-            break;
-        }
+    _searchResult = _engine.search(_searchPosition, _searchLimits, _searchHistory);
+    if (_searchResult.bestMove.isNone()) return { -1, -1 };
+
+    // Calculate and print out boards per second
+    const double boardsPerSecond = _searchResult.seconds > 0.0 ? static_cast<double>(_searchResult.nodes) / _searchResult.seconds : 0.0;
+    std::cout << "Moves checked: " << _searchResult.nodes << " (" << std::fixed << std::setprecision(2) << boardsPerSecond << " boards/s)" 
+        << std::defaultfloat << " DEPTH = " << _searchResult.depth << " THREADS = " << _engine.threadCount()
+        << " in " << _searchResult.seconds << "s" << std::endl;
+
+    // How often the first move searched was good enough for a cutoff, the closer to 100% the better the ordering
+    if (_searchResult.betaCutoffs > 0) {
+        std::cout << "First move cutoffs: " << std::fixed << std::setprecision(1)
+            << 100.0 * _searchResult.firstMoveCutoffs / _searchResult.betaCutoffs << "%" << std::defaultfloat << std::endl;
     }
 
-    return bestVal;
-}
-
-int Chess::evaluateBoard(const std::string& state)
-{
-    int value = 0;
-    int square = 0;
-    for (char ch : state) {
-        value += _evaluateScores[ch];
-        value += _pieceSquareTables[ch][square];
-        square++;
+    std::cout << "PV:";
+    for (int i = 0; i < _searchResult.pvLength; i++) {
+        std::cout << " " << moveToString(_searchResult.pv[i]);
     }
+    std::cout << " (" << _searchResult.score << ")" << std::endl;
 
-    return value;
+    return { _searchResult.bestMove.from(), _searchResult.bestMove.to() };
 }
@@ -3,22 +3,10 @@
 #include "Game.h"
 #include "Grid.h"
 #include "Bitboard.h"
+#include "Position.h"
+#include "ChessEngine.h"
 
 constexpr int pieceSize = 80;
-constexpr int negInfinite = -100000;
-constexpr int posInfinite = 100000;
-
-constexpr int MAX_DEPTH = 4;
-
-// Define constant bitmasks
-constexpr uint64_t NotAFile(0xFEFEFEFEFEFEFEFEULL); // A file mask
-constexpr uint64_t NotHFile(0x7F7F7F7F7F7F7F7FULL); // H file mask
-constexpr uint64_t Rank3(0x0000000000FF0000ULL); // Rank 3 mask
-constexpr uint64_t Rank6(0x0000FF0000000000ULL); // Rank 6 mask
-
-// Player color constants
-constexpr int WHITE = 0;
-constexpr int BLACK = 1;
 
 // enum ChessPiece
 // {
@@ -31,27 +19,6 @@ constexpr int BLACK = 1;
 //     King
 // };
 
-enum BitboardIndex
-{
-    WHITE_PAWNS,
-    BLACK_PAWNS,
-    WHITE_KNIGHTS,
-    BLACK_KNIGHTS,
-    WHITE_BISHOPS,
-    BLACK_BISHOPS,
-    WHITE_ROOKS,
-    BLACK_ROOKS,
-    WHITE_QUEENS,
-    BLACK_QUEENS,
-    WHITE_KING,
-    BLACK_KING,
-    WHITE_ALL_PIECES,
-    BLACK_ALL_PIECES,
-    OCCUPANCY,
-    EMPTY_SQUARES,
-    e_numBitboards
-};
-
 class Chess : public Game
 {
 public:
@@ -79,44 +46,38 @@ public:
 
     void updateAI() override;
     bool gameHasAI() override { return true; }
+    bool gameHasAsyncAI() override { return true; }
 
     Grid* getGrid() override { return _grid; }
 
+protected:
+    void prepareAISearch() override;
+    AIMove searchAIMove() override;
+    void applyAIMove(const AIMove& move) override;
+
 private:
 
-    int _countMoves = 0;
+    ChessEngine _engine;
+
+    // The game as the engine sees it, with the castling rights and en passant square the
+    // grid can't hold, kept in step with the grid by bitMovedFromTo
+    Position _position;
+    std::vector<uint64_t> _history; // Zobrist keys of the positions before _position, for repetitions
+    ChessPiece _promotionPiece = Queen; // the GUI has no promotion picker so people always get a queen
+
+    // Snapshot of the board taken on the main thread for the search thread to work on
+    Position _searchPosition;
+    std::vector<uint64_t> _searchHistory;
+    SearchLimits _searchLimits;
+    SearchResult _searchResult;
 
     Bit* PieceForPlayer(const int playerNumber, ChessPiece piece);
     Player* ownerAt(int x, int y) const;
     void FENtoBoard(const std::string& fen);
     char pieceNotation(int x, int y) const;
-
-    std::vector<BitMove> generateAllMoves(std::string& state, int playerColor);
-    BitboardElement generateKnightMoveBitboard(int square);
-    BitboardElement generateKingMoveBitboard(int square);
-
-    void generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, BitboardElement emptySquares);
-    void generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, BitboardElement emptySquares);
-    void generateBishopMoves(std::vector<BitMove>& moves, BitboardElement piecesBoard, BitboardElement occupancy, BitboardElement friendlies);
-    void generateRookMoves(std::vector<BitMove>& moves, BitboardElement piecesBoard, BitboardElement occupancy, BitboardElement friendlies);
-    void generateQueenMoves(std::vector<BitMove>& moves, BitboardElement piecesBoard, BitboardElement occupancy, BitboardElement friendlies);
-
-    void generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnsBoard, BitboardElement emptySquares, BitboardElement enemyOccupancyBoard, int color);
-    void addPawnBitboardMovesToList(std::vector<BitMove>& moves, const BitboardElement board, int shift);
-
-    int negamax(std::string& state, int depth, int alpha, int beta, int playerColor);
-
-    int evaluateBoard(const std::string& state);
+    bool findMove(int from, int to, BitMove& move) const;
+    void updateGridForMove(const BitMove& move);
 
     Grid* _grid;
-    BitboardElement _knightBitboards[64];
-    BitboardElement _kingBitboards[64];
-    std::vector<BitMove> _moves;
-
-    BitboardElement _bitboards[e_numBitboards];
-    int _bitboardLookup[128];
-
-    int _evaluateScores[128];
-
-    const int *_pieceSquareTables[128];
+    MoveList _moves;
 };
\ No newline at end of file
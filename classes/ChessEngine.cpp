@@ -0,0 +1,1330 @@
+#include "ChessEngine.h"
+#include "Evaluation.h"
+#include "MagicBitboards.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <thread>
+
+// Squares strictly between two squares on the same rank, file or diagonal, 0 otherwise
+struct BetweenTable {
+    uint64_t squares[64][64];
+};
+
+constexpr BetweenTable buildSquaresBetween()
+{
+    BetweenTable table{};
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            // The ray from a that reaches b meets the opposite ray from b on the squares between
+            for (int direction = 0; direction < 8; direction++) {
+                if (Rays.rays[direction][a] & (1ULL << b)) {
+                    table.squares[a][b] = Rays.rays[direction][a] & Rays.rays[(direction + 4) % 8][b];
+                }
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr BetweenTable betweenTable = buildSquaresBetween();
+static constexpr auto& squaresBetween = betweenTable.squares;
+
+// Plies taken off a late quiet move, by depth left and its place in the move ordering
+// Grows with the log of both, so deep searches reduce the tail of a long move list the most
+// std::log isn't constexpr, so this one is filled in once when the program starts
+static const auto lateMoveReductions = [] {
+    std::array<std::array<int, MAX_MOVES>, MAX_DEPTH> table{};
+    for (int depth = 1; depth < MAX_DEPTH; depth++) {
+        for (int move = 1; move < MAX_MOVES; move++) {
+            table[depth][move] = static_cast<int>(0.75 + std::log(depth) * std::log(move) / 2.25);
+        }
+    }
+    return table;
+}();
+
+// Mate scores count plies from the root, but the table is shared between nodes at every
+// ply, so they are stored counting from the node instead and converted back when read
+static inline int scoreToTT(int score, int ply)
+{
+    return score >= MATE_IN_MAX_PLY ? score + ply : score <= -MATE_IN_MAX_PLY ? score - ply : score;
+}
+
+static inline int scoreFromTT(int score, int ply)
+{
+    return score >= MATE_IN_MAX_PLY ? score - ply : score <= -MATE_IN_MAX_PLY ? score + ply : score;
+}
+
+// CAPTURE if an enemy piece stands on the square, QUIET_MOVE if not
+static inline int captureFlag(uint64_t enemies, int square)
+{
+    return static_cast<int>((enemies >> square) & 1) * CAPTURE;
+}
+
+ChessEngine::ChessEngine()
+    : _threadCount(1), _searchMode(SEARCH_LAZY_SMP), _stop(false)
+{
+}
+
+void ChessEngine::setThreadCount(int count)
+{
+    if (count <= 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    _threadCount = count;
+}
+
+//
+// Legal move generation
+// Instead of making every move and checking if the king is left attacked, work out up
+// front which squares a move may end on:
+//  - the king can go to any square the other side doesn't attack (with the king itself
+//    taken off the board so it can't hide behind itself from a slider)
+//  - in double check only the king can move
+//  - in single check everything else has to capture the checker or block the line to it
+//  - a piece pinned to the king can only move along the line of the pin
+// En passant can uncover a rank attack through both pawns at once, so that one move is
+// checked by taking both pawns off the board
+// Everything below is templated on the side to move so the pawn directions, ranks and
+// boards are constants, the color is only looked at once per call to generateAllMoves
+//
+void ChessEngine::generateAllMoves(const Position& position, int playerColor, MoveList& moves) const
+{
+    playerColor == WHITE ? generateMoves<WHITE, GEN_ALL>(position, moves) : generateMoves<BLACK, GEN_ALL>(position, moves);
+}
+
+// Captures and promotions only, for the quiescence search
+void ChessEngine::generateCaptures(const Position& position, int playerColor, MoveList& moves) const
+{
+    playerColor == WHITE ? generateMoves<WHITE, GEN_CAPTURES>(position, moves) : generateMoves<BLACK, GEN_CAPTURES>(position, moves);
+}
+
+// Everything generateCaptures leaves out
+void ChessEngine::generateQuiets(const Position& position, int playerColor, MoveList& moves) const
+{
+    playerColor == WHITE ? generateMoves<WHITE, GEN_QUIETS>(position, moves) : generateMoves<BLACK, GEN_QUIETS>(position, moves);
+}
+
+template <Color Us, MoveGenType Type>
+void ChessEngine::generateMoves(const Position& position, MoveList& moves) const
+{
+    using Our = Side<Us>;
+    using Their = Side<Our::Them>;
+
+    moves.clear();
+
+    const uint64_t kingBoard = position.pieces(Our::KING);
+    if (!kingBoard) return;
+
+    const int kingSquare = getFirstBit(kingBoard);
+    const uint64_t friendlies = position.pieces(Our::ALL_PIECES);
+    const uint64_t enemies = position.pieces(Their::ALL_PIECES);
+    const uint64_t occupancy = position.pieces(OCCUPANCY);
+    const uint64_t enemyRooks = position.pieces(Their::ROOKS) | position.pieces(Their::QUEENS);
+    const uint64_t enemyBishops = position.pieces(Their::BISHOPS) | position.pieces(Their::QUEENS);
+
+    // King moves first, they are the only ones left in double check
+    const uint64_t kingOccupancy = occupancy ^ kingBoard;
+    const uint64_t kingTargets = Type == GEN_CAPTURES ? enemies : Type == GEN_QUIETS ? position.pieces(EMPTY_SQUARES) : ~friendlies;
+    BitboardElement(KingAttacks[kingSquare] & kingTargets).forEachBit([&](int toSquare) {
+        if (!squareAttacked<Our::Them>(position, toSquare, kingOccupancy)) {
+            moves.emplace_back(kingSquare, toSquare, captureFlag(enemies, toSquare));
+        }
+    });
+
+    // Enemy sliders lined up with the king through nothing but their own pieces
+    // With nothing in between they give check, with exactly one of our pieces in between
+    // that piece is pinned and can only move along the line
+    uint64_t checkers = (Our::pawnAttacks(kingBoard) & position.pieces(Their::PAWNS)) |
+        (KnightAttacks[kingSquare] & position.pieces(Their::KNIGHTS));
+    uint64_t pinned = 0;
+    uint64_t pinRays[64];
+    const uint64_t snipers = (getRookAttacks(kingSquare, enemies) & enemyRooks) | (getBishopAttacks(kingSquare, enemies) & enemyBishops);
+    BitboardElement(snipers).forEachBit([&](int sniperSquare) {
+        const uint64_t between = squaresBetween[kingSquare][sniperSquare];
+        const uint64_t blockers = between & occupancy;
+        if (!blockers) {
+            checkers |= 1ULL << sniperSquare;
+        }
+        else if (!(blockers & (blockers - 1))) {
+            pinned |= blockers;
+            pinRays[getFirstBit(blockers)] = between | (1ULL << sniperSquare);
+        }
+    });
+
+    if (checkers & (checkers - 1)) return;
+
+    uint64_t checkMask = ~0ULL;
+    if (checkers) {
+        checkMask = checkers | squaresBetween[kingSquare][getFirstBit(checkers)];
+    }
+    else if (Type != GEN_CAPTURES) {
+        generateCastlingMoves<Us>(moves, position);
+    }
+
+    const uint64_t targets = kingTargets & checkMask;
+    // Pawn pushes only count as captures when they promote, and quiets take nothing
+    const uint64_t pushTargets = Type == GEN_CAPTURES ? checkMask & Our::PromotionRank :
+        Type == GEN_QUIETS ? checkMask & ~Our::PromotionRank : checkMask;
+    const uint64_t captureTargets = Type == GEN_QUIETS ? 0 : checkMask;
+
+    // Pinned knights can never move
+    generateKnightMoves(moves, position.pieces(Our::KNIGHTS) & ~pinned, targets, enemies);
+
+    const uint64_t pawns = position.pieces(Our::PAWNS);
+    const uint64_t empty = position.pieces(EMPTY_SQUARES);
+    generatePawnMoves<Us>(moves, pawns & ~pinned, empty, enemies, pushTargets, captureTargets);
+    BitboardElement(pawns & pinned).forEachBit([&](int square) {
+        generatePawnMoves<Us>(moves, 1ULL << square, empty, enemies, pushTargets & pinRays[square], captureTargets & pinRays[square]);
+    });
+    if (Type != GEN_QUIETS && position.epSquare != NO_SQUARE) {
+        generateEnPassantMoves<Us>(moves, position, kingSquare, checkMask);
+    }
+
+    generateSliderMoves(moves, position.pieces(Our::BISHOPS), Bishop, occupancy, targets, enemies, pinned, pinRays);
+    generateSliderMoves(moves, position.pieces(Our::ROOKS), Rook, occupancy, targets, enemies, pinned, pinRays);
+    generateSliderMoves(moves, position.pieces(Our::QUEENS), Queen, occupancy, targets, enemies, pinned, pinRays);
+}
+
+// The pieces of the given side that attack a square
+uint64_t ChessEngine::attackersTo(const Position& position, int square, int color, uint64_t occupancy) const
+{
+    const uint64_t squareBit = 1ULL << square;
+    const uint64_t queens = position.pieces(WHITE_QUEENS + color);
+
+    // A pawn attacks the square if a pawn of the other color on the square would attack it
+    const uint64_t pawnSources = color == WHITE ? Side<BLACK>::pawnAttacks(squareBit) : Side<WHITE>::pawnAttacks(squareBit);
+
+    return (pawnSources & position.pieces(WHITE_PAWNS + color)) |
+        (KnightAttacks[square] & position.pieces(WHITE_KNIGHTS + color)) |
+        (getBishopAttacks(square, occupancy) & (position.pieces(WHITE_BISHOPS + color) | queens)) |
+        (getRookAttacks(square, occupancy) & (position.pieces(WHITE_ROOKS + color) | queens)) |
+        (KingAttacks[square] & position.pieces(WHITE_KING + color));
+}
+
+// Whether the side Them attacks the square, like attackersTo but stops at the first
+// attacker, cheapest pieces first
+template <Color Them>
+bool ChessEngine::squareAttacked(const Position& position, int square, uint64_t occupancy) const
+{
+    using Their = Side<Them>;
+
+    if ((Side<Their::Them>::pawnAttacks(1ULL << square) & position.pieces(Their::PAWNS)) ||
+        (KnightAttacks[square] & position.pieces(Their::KNIGHTS)) ||
+        (KingAttacks[square] & position.pieces(Their::KING))) {
+        return true;
+    }
+
+    const uint64_t queens = position.pieces(Their::QUEENS);
+    const uint64_t bishops = position.pieces(Their::BISHOPS) | queens;
+    const uint64_t rooks = position.pieces(Their::ROOKS) | queens;
+    return (bishops && (getBishopAttacks(square, occupancy) & bishops)) ||
+        (rooks && (getRookAttacks(square, occupancy) & rooks));
+}
+
+// Anything but pawns and the king, without them zugzwang is common
+bool ChessEngine::hasPieces(const Position& position, int color)
+{
+    return (position.pieces(WHITE_KNIGHTS + color) | position.pieces(WHITE_BISHOPS + color) |
+        position.pieces(WHITE_ROOKS + color) | position.pieces(WHITE_QUEENS + color)) != 0;
+}
+
+bool ChessEngine::inCheck(const Position& position) const
+{
+    return position.sideToMove == WHITE ? inCheck<WHITE>(position) : inCheck<BLACK>(position);
+}
+
+template <Color Us>
+bool ChessEngine::inCheck(const Position& position) const
+{
+    const uint64_t king = position.pieces(Side<Us>::KING);
+    return king && squareAttacked<Side<Us>::Them>(position, getFirstBit(king), position.pieces(OCCUPANCY));
+}
+
+// Only called when not in check, the rook has to be home and the king can't pass over an attacked square
+template <Color Us>
+void ChessEngine::generateCastlingMoves(MoveList& moves, const Position& position) const
+{
+    using Our = Side<Us>;
+    constexpr int kingSquare = Our::KingHome;
+    const uint64_t occupancy = position.pieces(OCCUPANCY);
+    const uint64_t rooks = position.pieces(Our::ROOKS);
+
+    if ((position.castling & Our::Kingside) && (rooks & (1ULL << (kingSquare + 3)))) {
+        constexpr uint64_t path = (1ULL << (kingSquare + 1)) | (1ULL << (kingSquare + 2));
+        if (!(occupancy & path) &&
+            !squareAttacked<Our::Them>(position, kingSquare + 1, occupancy) &&
+            !squareAttacked<Our::Them>(position, kingSquare + 2, occupancy)) {
+            moves.emplace_back(kingSquare, kingSquare + 2, KING_CASTLE);
+        }
+    }
+    if ((position.castling & Our::Queenside) && (rooks & (1ULL << (kingSquare - 4)))) {
+        constexpr uint64_t path = (1ULL << (kingSquare - 1)) | (1ULL << (kingSquare - 2)) | (1ULL << (kingSquare - 3));
+        if (!(occupancy & path) &&
+            !squareAttacked<Our::Them>(position, kingSquare - 1, occupancy) &&
+            !squareAttacked<Our::Them>(position, kingSquare - 2, occupancy)) {
+            moves.emplace_back(kingSquare, kingSquare - 2, QUEEN_CASTLE);
+        }
+    }
+}
+
+template <Color Us>
+void ChessEngine::generateEnPassantMoves(MoveList& moves, const Position& position, int kingSquare, uint64_t checkMask) const
+{
+    using Our = Side<Us>;
+    using Their = Side<Our::Them>;
+
+    const int epSquare = position.epSquare;
+    const uint64_t epBit = 1ULL << epSquare;
+    const uint64_t capturedBit = 1ULL << (epSquare - Our::Up);
+
+    // Capturing has to get out of check, either by taking the checking pawn or by blocking
+    if (!(checkMask & (epBit | capturedBit))) return;
+
+    const uint64_t enemyRooks = position.pieces(Their::ROOKS) | position.pieces(Their::QUEENS);
+    const uint64_t enemyBishops = position.pieces(Their::BISHOPS) | position.pieces(Their::QUEENS);
+    const uint64_t capturers = Their::pawnAttacks(epBit) & position.pieces(Our::PAWNS);
+
+    BitboardElement(capturers).forEachBit([&](int fromSquare) {
+        const uint64_t occupancy = (position.pieces(OCCUPANCY) ^ (1ULL << fromSquare) ^ capturedBit) | epBit;
+        if (!(getRookAttacks(kingSquare, occupancy) & enemyRooks) && !(getBishopAttacks(kingSquare, occupancy) & enemyBishops)) {
+            moves.emplace_back(fromSquare, epSquare, EN_PASSANT);
+        }
+    });
+}
+
+uint64_t ChessEngine::perft(Position& position, int depth) const
+{
+    return position.sideToMove == WHITE ? perft<WHITE>(position, depth) : perft<BLACK>(position, depth);
+}
+
+template <Color Us>
+uint64_t ChessEngine::perft(Position& position, int depth) const
+{
+    if (depth == 0) return 1;
+
+    MoveList moves;
+    generateMoves<Us, GEN_ALL>(position, moves);
+
+    // No need to make the last ply, every move is a leaf
+    if (depth == 1) return moves.size();
+
+    uint64_t nodes = 0;
+    for (auto move : moves) {
+        UndoInfo undo;
+        position.makeMove<Us>(move, undo);
+        nodes += perft<Side<Us>::Them>(position, depth - 1);
+        position.unmakeMove<Us>(move, undo);
+    }
+    return nodes;
+}
+
+std::vector<std::pair<BitMove, uint64_t>> ChessEngine::divide(Position& position, int depth) const
+{
+    std::vector<std::pair<BitMove, uint64_t>> counts;
+    if (depth < 1) return counts;
+
+    MoveList moves;
+    generateAllMoves(position, position.sideToMove, moves);
+    for (auto move : moves) {
+        UndoInfo undo;
+        position.makeMove(move, undo);
+        counts.emplace_back(move, perft(position, depth - 1));
+        position.unmakeMove(move, undo);
+    }
+    return counts;
+}
+
+// Generate actual move objects from a bitboard
+void ChessEngine::generateKnightMoves(MoveList& moves, BitboardElement knightBoard, uint64_t targets, uint64_t enemies) const {
+    knightBoard.forEachBit([&](int fromSquare) {
+        BitboardElement moveBitboard = BitboardElement(KnightAttacks[fromSquare] & targets);
+        // Efficiently iterate through only the set bits
+        moveBitboard.forEachBit([&](int toSquare) {
+           moves.emplace_back(fromSquare, toSquare, captureFlag(enemies, toSquare));
+        });
+    });
+}
+
+// Bishops, rooks and queens, a pinned slider stays on the line of its pin
+void ChessEngine::generateSliderMoves(MoveList& moves, BitboardElement piecesBoard, ChessPiece piece, uint64_t occupancy, uint64_t targets, uint64_t enemies, uint64_t pinned, const uint64_t* pinRays) const
+{
+    piecesBoard.forEachBit([&](int fromSquare) {
+        uint64_t attacks = 0;
+        if (piece != Rook) attacks |= getBishopAttacks(fromSquare, occupancy);
+        if (piece != Bishop) attacks |= getRookAttacks(fromSquare, occupancy);
+        attacks &= targets;
+        if (pinned & (1ULL << fromSquare)) {
+            attacks &= pinRays[fromSquare];
+        }
+        BitboardElement moveBitboard = BitboardElement(attacks);
+        // Efficiently iterate through only the set bits
+        moveBitboard.forEachBit([&](int toSquare) {
+           moves.emplace_back(fromSquare, toSquare, captureFlag(enemies, toSquare));
+        });
+    });
+}
+
+template <Color Us>
+void ChessEngine::generatePawnMoves(MoveList& moves, uint64_t pawns, uint64_t emptySquares, uint64_t enemySquares, uint64_t pushTargets, uint64_t captureTargets) const
+{
+    using Our = Side<Us>;
+
+    if (!pawns) return;
+
+    // Single pushes, and a second push for the ones that started on their home rank
+    const uint64_t singleMoves = Our::forward(pawns) & emptySquares;
+    const uint64_t doubleMoves = Our::forward(singleMoves & Our::PushRank) & emptySquares;
+
+    // Only keep the moves that deal with a check or stay on a pin
+    addPawnMoves<Our::Up>(moves, singleMoves & pushTargets, QUIET_MOVE);
+    addPawnMoves<2 * Our::Up>(moves, doubleMoves & pushTargets, DOUBLE_PAWN_PUSH);
+    addPawnMoves<Our::CaptureWest>(moves, Our::attacksWest(pawns) & enemySquares & captureTargets, CAPTURE);
+    addPawnMoves<Our::CaptureEast>(moves, Our::attacksEast(pawns) & enemySquares & captureTargets, CAPTURE);
+}
+
+// Shift is how far each pawn moved to reach its target, a pawn only ever reaches the last
+// rank on its own side's way up the board so either end is a promotion
+template <int Shift>
+void ChessEngine::addPawnMoves(MoveList& moves, uint64_t targets, int flags) const
+{
+    BitboardElement(targets & ~(Rank1 | Rank8)).forEachBit([&](int toSquare) {
+        moves.emplace_back(toSquare - Shift, toSquare, flags);
+    });
+
+    // Queen first since it is almost always best
+    const int promotion = PROMOTION | (flags & CAPTURE);
+    BitboardElement(targets & (Rank1 | Rank8)).forEachBit([&](int toSquare) {
+        moves.emplace_back(toSquare - Shift, toSquare, promotion | (Queen - Knight));
+        moves.emplace_back(toSquare - Shift, toSquare, promotion);
+        moves.emplace_back(toSquare - Shift, toSquare, promotion | (Rook - Knight));
+        moves.emplace_back(toSquare - Shift, toSquare, promotion | (Bishop - Knight));
+    });
+}
+
+// The generator would have produced exactly this move, flags included. A move from the hash
+// table can belong to another position with the same low key bits, and a killer was found
+// in a sibling position, so neither can be trusted before it is checked
+template <Color Us>
+bool ChessEngine::isLegal(const Position& position, const BitMove& move) const
+{
+    using Our = Side<Us>;
+    using Their = Side<Our::Them>;
+
+    const int from = move.from();
+    const int to = move.to();
+    const int piece = position.pieceAt(from);
+    const uint64_t fromBit = 1ULL << from;
+    const uint64_t toBit = 1ULL << to;
+    const uint64_t occupancy = position.pieces(OCCUPANCY);
+
+    if (move.isNone() || piece == EMPTY_SQUARES || (piece & 1) != Us) return false;
+    if (position.pieces(Our::ALL_PIECES) & toBit) return false;
+
+    // Castling has enough conditions that it is simplest to ask the generator
+    if (move.isCastle()) {
+        if (piece != Our::KING || inCheck<Us>(position)) return false;
+        MoveList castles;
+        generateCastlingMoves<Us>(castles, position);
+        return std::find(castles.begin(), castles.end(), move) != castles.end();
+    }
+
+    // The capture flag has to agree with the board, en passant lands on an empty square
+    const bool enemyOnTo = (position.pieces(Their::ALL_PIECES) & toBit) != 0;
+    if (move.isEnPassant() ? to != position.epSquare : move.isCapture() != enemyOnTo) return false;
+
+    if (piece == Our::PAWNS) {
+        if (((toBit & Our::PromotionRank) != 0) != move.isPromotion()) return false;
+        if (move.isCapture()) {
+            // Flags 6 and 7 are unused and only turn up in a corrupt hash move
+            if (move.flags() > EN_PASSANT && !move.isPromotion()) return false;
+            if (!(Our::pawnAttacks(fromBit) & toBit)) return false;
+        }
+        else if (move.isDoublePawnPush()) {
+            const uint64_t passed = Our::forward(fromBit);
+            if (!(passed & Our::PushRank & ~occupancy) || Our::forward(passed) != toBit || (occupancy & toBit)) return false;
+        }
+        else if (Our::forward(fromBit) != toBit || (occupancy & toBit)) {
+            return false;
+        }
+    }
+    else {
+        if (move.flags() != QUIET_MOVE && move.flags() != CAPTURE) return false;
+        uint64_t attacks = 0;
+        switch (piece >> 1) {
+        case WHITE_KNIGHTS >> 1: attacks = KnightAttacks[from]; break;
+        case WHITE_BISHOPS >> 1: attacks = getBishopAttacks(from, occupancy); break;
+        case WHITE_ROOKS >> 1: attacks = getRookAttacks(from, occupancy); break;
+        case WHITE_QUEENS >> 1: attacks = getQueenAttacks(from, occupancy); break;
+        default: attacks = KingAttacks[from]; break;
+        }
+        if (!(attacks & toBit)) return false;
+    }
+
+    // Finally the king can't be left in check
+    if (piece == Our::KING) {
+        return !squareAttacked<Our::Them>(position, to, occupancy ^ fromBit);
+    }
+    uint64_t after = (occupancy ^ fromBit) | toBit;
+    uint64_t taken = toBit;
+    if (move.isEnPassant()) {
+        taken |= 1ULL << (to - Our::Up);
+        after ^= 1ULL << (to - Our::Up);
+    }
+    const int kingSquare = getFirstBit(position.pieces(Our::KING));
+    return !(attackersTo(position, kingSquare, Our::Them, after) & ~taken);
+}
+
+//
+// Lazy SMP: every thread searches the same root with its own copy of the position and
+// they only cooperate through the shared transposition table. Helpers start at different
+// depths and root moves so they fill the table with work the main thread hasn't done yet.
+// Only the main thread checks the limits and its result is the one reported.
+//
+// Root split: the root moves of each iteration are handed out to a work stealing pool
+// instead, see rootSplitIterativeDeepening
+//
+SearchResult ChessEngine::search(const Position& position, const SearchLimits& limits, const std::vector<uint64_t>& history)
+{
+    const auto searchStart = std::chrono::steady_clock::now();
+
+    _limits = limits;
+    _stop = false;
+    _useDeadline = limits.timeLimit > 0;
+    _searchStart = searchStart;
+    _searchDeadline = searchStart + std::chrono::milliseconds(limits.timeLimit);
+    _transpositionTable.newSearch();
+
+    // Nothing to search when the game is already over
+    SearchResult result;
+    MoveList moves;
+    generateAllMoves(position, position.sideToMove, moves);
+    if (moves.empty()) {
+        result.score = inCheck(position) ? -MATE_SCORE : DRAW_SCORE;
+        return result;
+    }
+
+    const bool rootSplit = _searchMode == SEARCH_ROOT_SPLIT;
+
+    // Search threads are kept between searches so their buffers only get allocated once
+    if (static_cast<int>(_threads.size()) != _threadCount) {
+        _threads.clear();
+        for (int i = 0; i < _threadCount; i++) {
+            _threads.push_back(std::make_unique<SearchThread>());
+            _threads.back()->rootMoves.reserve(MAX_MOVES);
+            _threads.back()->keys.reserve(100 + MAX_PLY);
+        }
+    }
+
+    // Nothing before the last capture or pawn move can come round again, and once the
+    // clock reaches 100 the search scores every node a draw without looking, so the keys
+    // never outgrow what the threads reserved
+    const size_t recent = std::min({ history.size(), static_cast<size_t>(position.halfmoveClock), size_t(100) });
+
+    for (int i = 0; i < _threadCount; i++) {
+        SearchThread& thread = *_threads[i];
+        thread.id = i;
+        thread.checksLimits = rootSplit || i == 0;
+        thread.position = position;
+        thread.nodes = 0;
+        thread.rootDepth = 0;
+        thread.completedDepth = 0;
+        thread.bestScore = negInfinite;
+        thread.ordering.newSearch();
+        thread.keys.assign(history.end() - recent, history.end());
+        thread.rootKey = static_cast<int>(recent);
+        thread.keys.resize(recent + MAX_PLY);
+        thread.keys[recent] = position.hash;
+        thread.rootMoves.clear();
+        for (auto move : moves) {
+            RootMove rootMove;
+            rootMove.move = move;
+            rootMove.score = negInfinite;
+            rootMove.exact = true;
+            thread.rootMoves.push_back(rootMove);
+        }
+        // The game went the way the last PV expected, start with the move it had next
+        if (position.hash == _expectedKey) {
+            auto expected = std::find_if(thread.rootMoves.begin(), thread.rootMoves.end(), [&](const RootMove& rootMove) {
+                return rootMove.move == _expectedMove;
+            });
+            if (expected != thread.rootMoves.end()) {
+                std::rotate(thread.rootMoves.begin(), expected, expected + 1);
+            }
+        }
+        // Give each Lazy SMP helper a different first root move
+        if (!rootSplit) {
+            std::rotate(thread.rootMoves.begin(), thread.rootMoves.begin() + (i % moves.size()), thread.rootMoves.end());
+        }
+    }
+
+    if (rootSplit) {
+        if (!_pool || _pool->workerCount() != _threadCount) {
+            _pool = std::make_unique<WorkStealingPool>(_threadCount);
+        }
+        rootSplitIterativeDeepening();
+    }
+    else {
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < _threadCount; i++) {
+            helpers.emplace_back([this, i]() { iterativeDeepening(*_threads[i]); });
+        }
+        iterativeDeepening(*_threads[0]);
+
+        _stop = true;
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+    }
+
+    result = mainThreadResult();
+
+    _expectedKey = 0;
+    if (result.pvLength >= 3) {
+        Position expected = position;
+        UndoInfo undo;
+        expected.makeMove(result.pv[0], undo);
+        expected.makeMove(result.pv[1], undo);
+        _expectedKey = expected.hash;
+        _expectedMove = result.pv[2];
+    }
+    return result;
+}
+
+void ChessEngine::newGame()
+{
+    _transpositionTable.clear();
+    for (auto& thread : _threads) {
+        thread->ordering.clear();
+    }
+    _expectedKey = 0;
+}
+
+// The main thread's best move and line from its last finished iteration
+SearchResult ChessEngine::mainThreadResult() const
+{
+    SearchResult result;
+    const SearchThread& mainThread = *_threads[0];
+    result.bestMove = mainThread.rootMoves[0].move;
+    result.score = mainThread.bestScore;
+    result.depth = mainThread.completedDepth;
+    result.pvLength = mainThread.rootMoves[0].pvLength;
+    std::copy(mainThread.rootMoves[0].pv, mainThread.rootMoves[0].pv + result.pvLength, result.pv);
+    if (result.pvLength == 0) {
+        result.pv[0] = result.bestMove;
+        result.pvLength = 1;
+    }
+    result.nodes = totalNodes();
+    for (const auto& thread : _threads) {
+        result.betaCutoffs += thread->ordering.betaCutoffs;
+        result.firstMoveCutoffs += thread->ordering.firstMoveCutoffs;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _searchStart).count();
+    return result;
+}
+
+void ChessEngine::reportIteration() const
+{
+    if (_limits.onIteration) {
+        _limits.onIteration(mainThreadResult());
+    }
+}
+
+// Best first, and an exact score before an upper bound that happens to be equal
+bool ChessEngine::betterRootMove(const RootMove& a, const RootMove& b)
+{
+    if (a.score != b.score) return a.score > b.score;
+    return a.exact && !b.exact;
+}
+
+// Stable insertion sort, the list is short and mostly sorted already, and unlike
+// std::stable_sort it never allocates a buffer
+void ChessEngine::sortRootMoves(std::vector<RootMove>& rootMoves)
+{
+    for (size_t i = 1; i < rootMoves.size(); i++) {
+        RootMove rootMove = rootMoves[i];
+        size_t j = i;
+        while (j > 0 && betterRootMove(rootMove, rootMoves[j - 1])) {
+            rootMoves[j] = rootMoves[j - 1];
+            j--;
+        }
+        rootMoves[j] = rootMove;
+    }
+}
+
+//
+// searches one ply deeper each iteration until the time, node or depth budget runs out
+// Each iteration starts with a narrow aspiration window around the last one's score, most
+// of the time the score lands inside it and everything outside is cut off straight away.
+// When it doesn't the window is widened on the side that failed and the iteration redone.
+//
+void ChessEngine::iterativeDeepening(SearchThread& thread)
+{
+    const auto searchStart = std::chrono::steady_clock::now();
+
+    // Odd helpers run one ply ahead of the others
+    const int startDepth = 1 + (thread.id & 1);
+
+    for (thread.rootDepth = startDepth; thread.rootDepth <= _limits.maxDepth; thread.rootDepth++) {
+        int window = ASPIRATION_WINDOW;
+        int alpha = negInfinite;
+        int beta = posInfinite;
+        if (thread.rootDepth >= ASPIRATION_MIN_DEPTH && thread.completedDepth > 0) {
+            alpha = std::max(thread.bestScore - window, negInfinite);
+            beta = std::min(thread.bestScore + window, posInfinite);
+        }
+
+        int score;
+        while (true) {
+            score = searchRoot(thread, thread.rootDepth, alpha, beta);
+            if (_stop) break;
+
+            if (score <= alpha && alpha > negInfinite) {
+                alpha = std::max(score - window, negInfinite);
+            }
+            else if (score >= beta && beta < posInfinite) {
+                beta = std::min(score + window, posInfinite);
+            }
+            else {
+                break;
+            }
+            window *= 2;
+        }
+
+        // An unfinished iteration can only have moved a root move ahead of the previous
+        // best by proving it better, so rootMoves[0] is still safe to play
+        if (_stop) break;
+
+        thread.completedDepth = thread.rootDepth;
+        thread.bestScore = score;
+        if (thread.id == 0) reportIteration();
+
+        if (thread.id == 0 && iterationOutOfTime(searchStart)) break;
+    }
+}
+
+//
+// Searches the root moves in order inside the window, the first with the full window and
+// the rest with a null window that only asks whether they beat the best so far (PVS)
+// A move that does is searched again for its real score and moved to the front of the
+// list, so the next iteration and any re-search start with it
+//
+int ChessEngine::searchRoot(SearchThread& thread, int depth, int alpha, int beta)
+{
+    std::vector<RootMove>& rootMoves = thread.rootMoves;
+    int bestScore = negInfinite;
+
+    for (size_t i = 0; i < rootMoves.size(); i++) {
+        const int score = searchRootMove(thread, rootMoves[i], depth, alpha, beta, i == 0);
+        if (_stop) break;
+
+        bestScore = std::max(bestScore, score);
+        if (score > alpha) {
+            std::rotate(rootMoves.begin(), rootMoves.begin() + i, rootMoves.begin() + i + 1);
+            if (score >= beta) break;
+            alpha = score;
+        }
+    }
+    return bestScore;
+}
+
+//
+// Root split iterative deepening, the root move list lives in the main thread
+// The first (best so far) move is searched alone so there is a real alpha, then the rest
+// are spread over the pool. Each worker searches with its own SearchThread and position
+// copy, and the best score so far is shared so later moves are still searched with a
+// narrow window and cut off early.
+//
+void ChessEngine::rootSplitIterativeDeepening()
+{
+    const auto searchStart = std::chrono::steady_clock::now();
+    SearchThread& mainThread = *_threads[0];
+    std::vector<RootMove>& rootMoves = mainThread.rootMoves;
+
+    for (int depth = 1; depth <= _limits.maxDepth; depth++) {
+        for (auto& thread : _threads) {
+            thread->rootDepth = depth;
+        }
+
+        const int firstScore = searchRootMove(mainThread, rootMoves[0], depth, negInfinite, posInfinite, true);
+        if (_stop) break;
+
+        std::atomic<int> sharedAlpha(firstScore);
+        _pool->run(static_cast<int>(rootMoves.size()) - 1, [&](int worker, int item) {
+            if (_stop.load(std::memory_order_relaxed)) return;
+
+            RootMove& rootMove = rootMoves[item + 1];
+            const int alpha = sharedAlpha.load(std::memory_order_relaxed);
+            const int score = searchRootMove(*_threads[worker], rootMove, depth, alpha, posInfinite, false);
+            if (_stop.load(std::memory_order_relaxed)) return;
+
+            // Raise the shared alpha if this move is the new best
+            int current = sharedAlpha.load(std::memory_order_relaxed);
+            while (score > current && !sharedAlpha.compare_exchange_weak(current, score, std::memory_order_relaxed)) {
+            }
+        });
+
+        // An unfinished iteration can't be trusted, keep the previous one's move
+        if (_stop) break;
+
+        sortRootMoves(rootMoves);
+        mainThread.completedDepth = depth;
+        mainThread.bestScore = rootMoves[0].score;
+        reportIteration();
+
+        if (iterationOutOfTime(searchStart)) break;
+    }
+}
+
+// Search one root move and record its score, and its PV if it beats alpha
+// Without fullWindow it is first searched with a null window, which is much cheaper and
+// all that is needed to show the move is no better than alpha
+int ChessEngine::searchRootMove(SearchThread& thread, RootMove& rootMove, int depth, int alpha, int beta, bool fullWindow)
+{
+    // Make the move, from here on every node knows its side to move at compile time
+    UndoInfo undo;
+    thread.position.makeMove(rootMove.move, undo);
+    const auto search = thread.position.sideToMove == WHITE ? &ChessEngine::negamax<WHITE> : &ChessEngine::negamax<BLACK>;
+
+    int moveVal;
+    if (fullWindow) {
+        moveVal = -(this->*search)(thread, depth - 1, 1, -beta, -alpha);
+    }
+    else {
+        moveVal = -(this->*search)(thread, depth - 1, 1, -alpha - 1, -alpha);
+        if (moveVal > alpha && moveVal < beta && !_stop.load(std::memory_order_relaxed)) {
+            moveVal = -(this->*search)(thread, depth - 1, 1, -beta, -alpha);
+        }
+    }
+
+    // Undo the move
+    thread.position.unmakeMove(rootMove.move, undo);
+
+    if (_stop.load(std::memory_order_relaxed)) return moveVal;
+
+    rootMove.score = moveVal;
+    rootMove.exact = moveVal > alpha && moveVal < beta;
+    if (moveVal > alpha) {
+        updatePv(thread, 0, rootMove.move);
+        rootMove.pvLength = thread.pvLength[0];
+        std::copy(thread.pv[0], thread.pv[0] + rootMove.pvLength, rootMove.pv);
+    }
+    return moveVal;
+}
+
+// The move is the best at this ply, so the line from here is it followed by the line
+// the child found
+void ChessEngine::updatePv(SearchThread& thread, int ply, const BitMove& move)
+{
+    const int childLength = ply + 1 < MAX_PLY ? thread.pvLength[ply + 1] : ply + 1;
+    thread.pv[ply][ply] = move;
+    for (int i = ply + 1; i < childLength; i++) {
+        thread.pv[ply][i] = thread.pv[ply + 1][i];
+    }
+    thread.pvLength[ply] = std::max(childLength, ply + 1);
+}
+
+// The next iteration takes several times longer than the last one, so don't start
+// it if it can't finish inside the budget
+bool ChessEngine::iterationOutOfTime(std::chrono::steady_clock::time_point searchStart) const
+{
+    if (!_useDeadline) return false;
+    const auto elapsed = std::chrono::steady_clock::now() - searchStart;
+    return elapsed * 2 > std::chrono::milliseconds(_limits.timeLimit);
+}
+
+void ChessEngine::checkSearchLimits(SearchThread& thread)
+{
+    // The owner is throwing this search away
+    if (_limits.cancel && _limits.cancel->load(std::memory_order_relaxed)) {
+        _stop = true;
+        return;
+    }
+
+    // Always let the first iteration finish so there is a move to play
+    if (thread.rootDepth <= 1) return;
+
+    if (_limits.nodeLimit > 0 && totalNodes() >= _limits.nodeLimit) {
+        _stop = true;
+    }
+    if (_useDeadline && std::chrono::steady_clock::now() >= _searchDeadline) {
+        _stop = true;
+    }
+}
+
+long long ChessEngine::totalNodes() const
+{
+    long long nodes = 0;
+    for (const auto& thread : _threads) {
+        nodes += thread->nodes.load(std::memory_order_relaxed);
+    }
+    return nodes;
+}
+
+// Count a node and check the limits every so often, true once the search has been stopped
+bool ChessEngine::countNode(SearchThread& thread)
+{
+    // Only this thread writes its counter, the atomic is just so the main thread can sum them
+    const long long nodes = thread.nodes.load(std::memory_order_relaxed) + 1;
+    thread.nodes.store(nodes, std::memory_order_relaxed);
+
+    if (thread.checksLimits && (nodes & 2047) == 0) {
+        checkSearchLimits(thread);
+    }
+    return _stop.load(std::memory_order_relaxed);
+}
+
+//
+// Hands negamax its moves one at a time in stages, each one only generated once the
+// stages before it are used up:
+//  1. the hash table's move, straight from the table after checking it is legal
+//  2. captures and promotions, most valuable victim first
+//  3. the killer moves for the ply, again checked for legality
+//  4. the remaining quiet moves by history
+// Most cut nodes are refuted by the hash move or a capture, so they never generate quiets
+// Moves handed out in an earlier stage are skipped when a later one generates them again
+//
+template <Color Us>
+class ChessEngine::MovePicker {
+public:
+    MovePicker(const ChessEngine& engine, const Position& position, const MoveOrdering& ordering, const BitMove& ttMove, int ply)
+        : _engine(engine), _position(position), _ordering(ordering), _ttMove(ttMove), _ply(ply)
+    {
+        _killers[0] = ordering.killersAt(ply)[0];
+        _killers[1] = ordering.killersAt(ply)[1];
+    }
+
+    // An empty move once every stage is done
+    BitMove next()
+    {
+        while (true) {
+            switch (_stage) {
+            case STAGE_TT_MOVE:
+                _stage = STAGE_GENERATE_CAPTURES;
+                if (_engine.isLegal<Us>(_position, _ttMove)) return _ttMove;
+                _ttMove = BitMove();
+                break;
+
+            case STAGE_GENERATE_CAPTURES:
+                _engine.generateMoves<Us, GEN_CAPTURES>(_position, _moves);
+                _ordering.scoreMoves(_position, _moves, BitMove(), _ply, _scores);
+                _index = 0;
+                _stage = STAGE_CAPTURES;
+                break;
+
+            case STAGE_CAPTURES:
+                while (_index < _moves.size()) {
+                    MoveOrdering::pickNext(_moves, _scores, _index);
+                    const BitMove move = _moves[_index++];
+                    if (!(move == _ttMove)) return move;
+                }
+                _index = 0;
+                _stage = STAGE_KILLERS;
+                break;
+
+            case STAGE_KILLERS:
+                while (_index < 2) {
+                    const BitMove killer = _killers[_index++];
+                    if (!(killer == _ttMove) && _engine.isLegal<Us>(_position, killer)) return killer;
+                    _killers[_index - 1] = BitMove();
+                }
+                _stage = STAGE_GENERATE_QUIETS;
+                break;
+
+            case STAGE_GENERATE_QUIETS:
+                _engine.generateMoves<Us, GEN_QUIETS>(_position, _moves);
+                _ordering.scoreMoves(_position, _moves, BitMove(), _ply, _scores);
+                _index = 0;
+                _stage = STAGE_QUIETS;
+                break;
+
+            case STAGE_QUIETS:
+                while (_index < _moves.size()) {
+                    MoveOrdering::pickNext(_moves, _scores, _index);
+                    const BitMove move = _moves[_index++];
+                    if (!(move == _ttMove) && !(move == _killers[0]) && !(move == _killers[1])) return move;
+                }
+                _stage = STAGE_DONE;
+                break;
+
+            default:
+                return BitMove();
+            }
+        }
+    }
+
+private:
+    enum Stage {
+        STAGE_TT_MOVE,
+        STAGE_GENERATE_CAPTURES,
+        STAGE_CAPTURES,
+        STAGE_KILLERS,
+        STAGE_GENERATE_QUIETS,
+        STAGE_QUIETS,
+        STAGE_DONE
+    };
+
+    const ChessEngine& _engine;
+    const Position& _position;
+    const MoveOrdering& _ordering;
+    BitMove _ttMove;      // cleared if it isn't legal here, so nothing is skipped for it
+    BitMove _killers[2];  // likewise
+    int _ply;
+    int _stage = STAGE_TT_MOVE;
+    int _index = 0;
+    MoveList _moves;
+    int _scores[MAX_MOVES];
+};
+
+bool ChessEngine::isLegal(const Position& position, const BitMove& move) const
+{
+    return position.sideToMove == WHITE ? isLegal<WHITE>(position, move) : isLegal<BLACK>(position, move);
+}
+
+void ChessEngine::pickedMoves(const Position& position, const MoveOrdering& ordering, const BitMove& ttMove, int ply, MoveList& moves) const
+{
+    moves.clear();
+    if (position.sideToMove == WHITE) {
+        MovePicker<WHITE> picker(*this, position, ordering, ttMove, ply);
+        for (BitMove move = picker.next(); !move.isNone(); move = picker.next()) moves.push_back(move);
+    }
+    else {
+        MovePicker<BLACK> picker(*this, position, ordering, ttMove, ply);
+        for (BitMove move = picker.next(); !move.isNone(); move = picker.next()) moves.push_back(move);
+    }
+}
+
+//
+// Principal variation search: the first move is searched with the full window and the
+// rest with a null window around alpha, which can only say whether a move beats it. With
+// good move ordering the first move is nearly always best, and when a later one turns
+// out better it is searched again with the full window for its real score.
+// Us is the side to move, the children are searched with the other side
+//
+template <Color Us>
+int ChessEngine::negamax(SearchThread& thread, int depth, int ply, int alpha, int beta)
+{
+    constexpr Color Them = Side<Us>::Them;
+    Position& position = thread.position;
+    thread.pvLength[ply] = ply;
+
+    // Base case, play out the captures first so the score isn't taken halfway through an exchange
+    if (depth <= 0) {
+        return quiescence<Us>(thread, ply, alpha, beta);
+    }
+
+    if (countNode(thread)) return 0;
+
+    // A draw can be claimed, a line that repeats a position can be repeated forever
+    thread.keys[thread.rootKey + ply] = position.hash;
+    if (isRepetition(position, thread.keys.data(), thread.rootKey + ply, ply)) {
+        return DRAW_SCORE;
+    }
+    // Except that mate on the hundredth ply still wins, so in check the fifty move rule
+    // only applies if there is a move to get out of it
+    if (position.halfmoveClock >= 100) {
+        if (!inCheck<Us>(position)) return DRAW_SCORE;
+        MoveList evasions;
+        generateMoves<Us, GEN_ALL>(position, evasions);
+        return evasions.empty() ? -MATE_SCORE + ply : DRAW_SCORE;
+    }
+
+    // Mate distance pruning: even mating on the next move can't beat a shorter mate
+    // already found, and being mated here can't be worse than being mated right now
+    alpha = std::max(alpha, -MATE_SCORE + ply);
+    beta = std::min(beta, MATE_SCORE - ply - 1);
+    if (alpha >= beta) return alpha;
+
+    // Check the transposition table for a result from an earlier visit to this position
+    // Only null window nodes take a cutoff from it, on the PV it would cut the line short
+    const bool pvNode = beta - alpha > 1;
+    const int alphaOrig = alpha;
+    TTData ttData;
+    BitMove ttMove;
+    if (_transpositionTable.probe(position.hash, ttData)) {
+        ttMove = ttData.move;
+        const int ttScore = scoreFromTT(ttData.score, ply);
+        if (!pvNode && ttData.depth >= depth) {
+            if (ttData.bound == TT_EXACT) {
+                return ttScore;
+            }
+            if (ttData.bound == TT_LOWER) {
+                alpha = std::max(alpha, ttScore);
+            }
+            else if (ttData.bound == TT_UPPER) {
+                beta = std::min(beta, ttScore);
+            }
+            if (alpha >= beta) {
+                return ttScore;
+            }
+        }
+    }
+
+    // Selective search, none of it is safe in check or worth the risk on the PV, or when
+    // a mate score is at stake and the static score says nothing about it
+    const bool checked = inCheck<Us>(position);
+    const bool selective = !pvNode && !checked && std::abs(beta) < MATE_IN_MAX_PLY;
+    const int staticEval = Us == WHITE ? evaluateBoard(position) : -evaluateBoard(position);
+
+    // Reverse futility: so far above beta near the leaves that the few plies left won't
+    // bring the score back down to it
+    if (_options.futilityPruning && selective && depth <= FUTILITY_MAX_DEPTH && staticEval - FUTILITY_MARGIN * depth >= beta) {
+        return staticEval;
+    }
+
+    // Null move: let the opponent move twice, if a reduced search still can't get the
+    // score below beta a real move almost certainly won't either. Zugzwang is where that
+    // goes wrong, so never with only pawns left and never twice in a row.
+    if (_options.nullMovePruning && selective && depth >= NULL_MOVE_MIN_DEPTH && staticEval >= beta &&
+        !(ply > 0 && thread.nullMove[ply - 1]) && hasPieces(position, Us)) {
+        const int reduction = 2 + depth / 4;
+
+        UndoInfo undo;
+        position.makeNullMove(undo);
+        thread.nullMove[ply] = true;
+        const int nullVal = -negamax<Them>(thread, depth - 1 - reduction, ply + 1, -beta, -beta + 1);
+        thread.nullMove[ply] = false;
+        position.unmakeNullMove(undo);
+
+        if (_stop.load(std::memory_order_relaxed)) return 0;
+        // Passing proves nothing about a mate, so don't pass one on
+        if (nullVal >= beta) return nullVal >= MATE_IN_MAX_PLY ? beta : nullVal;
+    }
+
+    // Forward futility: a quiet move can't raise a score this far below alpha
+    const bool futile = _options.futilityPruning && selective && depth <= FUTILITY_MAX_DEPTH &&
+        staticEval + FUTILITY_MARGIN * depth <= alpha;
+
+    // Moves come out best first and are only generated as they are needed, a cutoff
+    // usually comes early so most nodes never generate their quiet moves
+    MovePicker<Us> picker(*this, position, thread.ordering, ttMove, ply);
+
+    // Quiet moves that didn't cause a cutoff, their history is lowered if a later one does
+    MoveList quietsSearched;
+
+    int bestVal = negInfinite; // Min value
+    BitMove bestMove;
+
+    int i = 0;
+    for (BitMove move = picker.next(); !move.isNone(); move = picker.next(), i++) {
+        const bool quiet = !move.isCapture() && !move.isPromotion();
+
+        // Make the move
+        UndoInfo undo;
+        position.makeMove<Us>(move, undo);
+        const bool givesCheck = inCheck<Them>(position);
+
+        if (futile && quiet && i > 0 && !givesCheck) {
+            position.unmakeMove<Us>(move, undo);
+            continue;
+        }
+
+        // Recursively evaluate (note the negation, makeMove flips the side to move)
+        int moveVal;
+        if (i == 0) {
+            moveVal = -negamax<Them>(thread, depth - 1, ply + 1, -beta, -alpha);
+        }
+        else {
+            // Late move reductions: moves this far down the ordering rarely turn out best,
+            // so look at them less deeply and only search properly if one beats alpha
+            int reduction = 0;
+            if (_options.lateMoveReductions && quiet && !checked && !givesCheck && depth >= LMR_MIN_DEPTH && i >= LMR_MIN_MOVE) {
+                reduction = lateMoveReductions[std::min(depth, MAX_DEPTH - 1)][std::min(i, MAX_MOVES - 1)];
+                if (pvNode) reduction--;
+                reduction = std::clamp(reduction, 0, depth - 2);
+            }
+
+            moveVal = -negamax<Them>(thread, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (reduction > 0 && moveVal > alpha) {
+                moveVal = -negamax<Them>(thread, depth - 1, ply + 1, -alpha - 1, -alpha);
+            }
+            if (moveVal > alpha && moveVal < beta) {
+                moveVal = -negamax<Them>(thread, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+
+        // Undo the move
+        position.unmakeMove<Us>(move, undo);
+
+        // The result is meaningless once the search is stopped, don't let it reach the table
+        if (_stop.load(std::memory_order_relaxed)) return 0;
+
+        if (moveVal > bestVal) {
+            bestVal = moveVal;
+            bestMove = move;
+            if (moveVal > alpha) {
+                updatePv(thread, ply, move);
+            }
+        }
+
+        // Alpha-beta pruning
+        alpha = std::max(alpha, bestVal);
+
+        if (alpha >= beta) {
+            thread.ordering.cutoff(position, move, depth, ply, i, quietsSearched);
+            break;
+        }
+
+        if (quiet) {
+            quietsSearched.push_back(move);
+        }
+    }
+
+    // No legal moves, checkmate or stalemate, the sooner the mate the better the score
+    if (bestVal == negInfinite) {
+        return checked ? -MATE_SCORE + ply : DRAW_SCORE;
+    }
+
+    TTBound bound = TT_EXACT;
+    if (bestVal <= alphaOrig) {
+        bound = TT_UPPER;
+    }
+    else if (bestVal >= beta) {
+        bound = TT_LOWER;
+    }
+    _transpositionTable.store(position.hash, depth, scoreToTT(bestVal, ply), bound, bestMove);
+
+    return bestVal;
+}
+
+//
+// Quiescence search, only captures and promotions are searched so the score at the end of
+// the main search is taken from a quiet position
+// The side to move can always "stand pat" on the static score instead of capturing, so that
+// is a lower bound. A capture is skipped when even winning the piece for free can't bring
+// the score up to alpha (delta pruning) or when the exchange on the square loses material.
+// In check every move is searched and there is no standing pat, the check has to be answered,
+// and if it can't be that is mate.
+//
+template <Color Us>
+int ChessEngine::quiescence(SearchThread& thread, int ply, int alpha, int beta)
+{
+    Position& position = thread.position;
+    thread.pvLength[ply] = ply; // the PV stops where the quiescence search starts
+
+    if (countNode(thread)) return 0;
+
+    // Negate for black because evaluate function evaluates for white
+    const int standPat = Us == WHITE ? evaluateBoard(position) : -evaluateBoard(position);
+    if (ply >= MAX_PLY - 1) return standPat;
+
+    const bool checked = inCheck<Us>(position);
+    int bestVal = negInfinite;
+    if (!checked) {
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+        bestVal = standPat;
+    }
+
+    MoveList moves;
+    if (checked) {
+        generateMoves<Us, GEN_ALL>(position, moves);
+        if (moves.empty()) return -MATE_SCORE + ply;
+    }
+    else {
+        generateMoves<Us, GEN_CAPTURES>(position, moves);
+    }
+
+    int scores[MAX_MOVES];
+    thread.ordering.scoreMoves(position, moves, BitMove(), ply, scores);
+
+    for (int i = 0; i < moves.size(); i++) {
+        MoveOrdering::pickNext(moves, scores, i);
+        const BitMove move = moves[i];
+
+        if (!checked) {
+            // A promotion push takes nothing
+            const int captured = position.capturedPiece(move);
+            int gain = captured != EMPTY_SQUARES ? pieceValues[captured & ~1] : 0;
+            if (move.isPromotion()) {
+                gain += pieceValues[(move.promotion() - 1) * 2] - pieceValues[WHITE_PAWNS];
+            }
+            if (standPat + gain + QUIESCENCE_DELTA_MARGIN <= alpha) continue;
+            if (staticExchange(position, move) < 0) continue;
+        }
+
+        UndoInfo undo;
+        position.makeMove<Us>(move, undo);
+        int moveVal = -quiescence<Side<Us>::Them>(thread, ply + 1, -beta, -alpha);
+        position.unmakeMove<Us>(move, undo);
+
+        if (_stop.load(std::memory_order_relaxed)) return 0;
+
+        if (moveVal > bestVal) {
+            bestVal = moveVal;
+            if (moveVal > alpha) {
+                alpha = moveVal;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    return bestVal;
+}
+
+int ChessEngine::staticExchange(const Position& position, const BitMove& move) const
+{
+    const int to = move.to();
+    uint64_t occupancy = position.pieces(OCCUPANCY) ^ (1ULL << move.from());
+
+    int gain[32];
+    int depth = 0;
+    const int captured = position.capturedPiece(move);
+    gain[0] = captured != EMPTY_SQUARES ? pieceValues[captured & ~1] : 0;
+    if (move.isEnPassant()) {
+        occupancy ^= 1ULL << (to ^ 8);
+    }
+
+    // Value of the piece now standing on the square, the next capture wins it
+    int onSquare = pieceValues[position.movedPiece(move) & ~1];
+    if (move.isPromotion()) {
+        const int promoted = pieceValues[(move.promotion() - 1) * 2];
+        gain[0] += promoted - pieceValues[WHITE_PAWNS];
+        onSquare = promoted;
+    }
+
+    const uint64_t bishops = position.pieces(WHITE_BISHOPS) | position.pieces(BLACK_BISHOPS) | position.pieces(WHITE_QUEENS) | position.pieces(BLACK_QUEENS);
+    const uint64_t rooks = position.pieces(WHITE_ROOKS) | position.pieces(BLACK_ROOKS) | position.pieces(WHITE_QUEENS) | position.pieces(BLACK_QUEENS);
+    uint64_t attackers = (attackersTo(position, to, WHITE, occupancy) | attackersTo(position, to, BLACK, occupancy)) & occupancy;
+    int side = position.sideToMove ^ 1;
+
+    while (depth < 31) {
+        // The cheapest piece the side has on the square
+        int attacker = -1;
+        for (int piece = WHITE_PAWNS + side; piece <= BLACK_KING; piece += 2) {
+            if (attackers & position.pieces(piece)) {
+                attacker = piece;
+                break;
+            }
+        }
+        if (attacker < 0) break;
+
+        depth++;
+        gain[depth] = onSquare - gain[depth - 1];
+        // Neither side can do better by carrying on, stop early
+        if (std::max(-gain[depth - 1], gain[depth]) < 0) break;
+
+        const uint64_t attackerBit = attackers & position.pieces(attacker) & (0 - (attackers & position.pieces(attacker)));
+        occupancy ^= attackerBit;
+        // Sliders lined up behind the piece that just moved now see the square
+        attackers |= (getBishopAttacks(to, occupancy) & bishops) | (getRookAttacks(to, occupancy) & rooks);
+        attackers &= occupancy;
+
+        onSquare = pieceValues[attacker & ~1];
+        side ^= 1;
+    }
+
+    // Each side can stop capturing when carrying on would lose material
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+// Material and piece squares are kept up to date by the position as moves are made,
+// all that's left is blending the middlegame and endgame scores by the phase
+int ChessEngine::evaluateBoard(const Position& position) const
+{
+    return taperedScore(position.middlegame, position.endgame, position.phase);
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "MoveList.h"
+#include "MoveOrdering.h"
+#include "Position.h"
+#include "TranspositionTable.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+constexpr int negInfinite = -100000;
+constexpr int posInfinite = 100000;
+constexpr int DRAW_SCORE = 0;           // repetitions, the fifty move rule and stalemate
+constexpr int MATE_SCORE = 90000;       // being mated n plies from the root scores n - MATE_SCORE
+constexpr int MATE_IN_MAX_PLY = MATE_SCORE - MAX_PLY; // scores at least this far from 0 are mates
+
+constexpr int MAX_DEPTH = 64;          // Iterative deepening never searches deeper than this
+constexpr int QUIESCENCE_DELTA_MARGIN = 200; // Positional swing allowed for when delta pruning captures
+constexpr int ASPIRATION_WINDOW = 25;  // First window either side of the last iteration's score, doubled on each fail
+constexpr int ASPIRATION_MIN_DEPTH = 4; // Shallower iterations are cheap and their scores still jump, use the full window
+constexpr int NULL_MOVE_MIN_DEPTH = 3;  // Null move pruning is only tried with at least this much depth left
+constexpr int LMR_MIN_DEPTH = 3;        // Late moves are only reduced with at least this much depth left
+constexpr int LMR_MIN_MOVE = 3;         // The first moves in the ordering are never reduced
+constexpr int FUTILITY_MAX_DEPTH = 3;   // Futility pruning only looks this close to the leaves
+constexpr int FUTILITY_MARGIN = 120;    // Score swing allowed for per ply of depth left
+constexpr int AI_TIME_LIMIT_MS = 1000; // Default time budget for each AI move
+
+// Define constant bitmasks
+constexpr uint64_t NotAFile(0xFEFEFEFEFEFEFEFEULL); // A file mask
+constexpr uint64_t NotHFile(0x7F7F7F7F7F7F7F7FULL); // H file mask
+constexpr uint64_t Rank3(0x0000000000FF0000ULL); // Rank 3 mask
+constexpr uint64_t Rank6(0x0000FF0000000000ULL); // Rank 6 mask
+constexpr uint64_t Rank1(0x00000000000000FFULL); // Rank 1 mask
+constexpr uint64_t Rank8(0xFF00000000000000ULL); // Rank 8 mask
+
+// Which of the legal moves to generate, captures includes every promotion
+enum MoveGenType
+{
+    GEN_ALL,
+    GEN_CAPTURES,
+    GEN_QUIETS
+};
+
+enum SearchMode
+{
+    SEARCH_LAZY_SMP,   // every thread searches the whole tree, sharing the hash table
+    SEARCH_ROOT_SPLIT  // root moves are shared out between the threads
+};
+
+// Selective search features, each can be switched off to measure what it is worth
+struct SearchOptions {
+    bool nullMovePruning = true;
+    bool lateMoveReductions = true;
+    bool futilityPruning = true;   // reverse futility at the node and forward futility of quiet moves
+};
+
+struct SearchResult;
+
+struct SearchLimits {
+    int maxDepth = MAX_DEPTH;
+    int timeLimit = 0;        // milliseconds, 0 for no limit
+    long long nodeLimit = 0;  // 0 for no limit
+    const std::atomic<bool>* cancel = nullptr; // set by the owner to abandon the search
+
+    // Called on the search thread each time the main thread finishes an iteration, with
+    // the result so far, so a front end can show progress while it searches
+    std::function<void(const SearchResult&)> onIteration;
+};
+
+struct SearchResult {
+    BitMove bestMove;
+    int score = negInfinite;
+    int depth = 0;            // last iteration the main thread finished, 0 if none
+    long long nodes = 0;      // summed over every search thread
+    double seconds = 0.0;
+
+    // Principal variation from the last finished iteration, starting with bestMove
+    BitMove pv[MAX_PLY];
+    int pvLength = 0;
+
+    // Summed over every search thread, firstMoveCutoffs / betaCutoffs shows how good the move ordering is
+    long long betaCutoffs = 0;
+    long long firstMoveCutoffs = 0;
+};
+
+//
+// The chess AI without any of the GUI, so it can run on the GUI's worker thread or headless
+// Move generation and evaluation are read only; everything a search writes lives in a
+// SearchThread so several threads can search the same position at once, either all of
+// them over the whole tree (Lazy SMP) or each taking a share of the root moves
+//
+class ChessEngine
+{
+public:
+    ChessEngine();
+
+    // Legal moves only
+    void generateAllMoves(const Position& position, int playerColor, MoveList& moves) const;
+    void generateCaptures(const Position& position, int playerColor, MoveList& moves) const;
+    void generateQuiets(const Position& position, int playerColor, MoveList& moves) const;
+    // Whether the move can be played in the position, for moves that didn't come from the
+    // generator. The search uses it on hash table moves and killers
+    bool isLegal(const Position& position, const BitMove& move) const;
+    // Every legal move in the order the search's move picker hands them out
+    void pickedMoves(const Position& position, const MoveOrdering& ordering, const BitMove& ttMove, int ply, MoveList& moves) const;
+    int evaluateBoard(const Position& position) const;
+    bool inCheck(const Position& position) const;
+
+    // Static exchange evaluation, the material the side to move ends up with after every
+    // capture on the move's square, each side always recapturing with its cheapest piece
+    int staticExchange(const Position& position, const BitMove& move) const;
+
+    // Count the leaf nodes of the move generator's tree to the given depth, and the same
+    // split up by root move, for checking the generator against known counts
+    uint64_t perft(Position& position, int depth) const;
+    std::vector<std::pair<BitMove, uint64_t>> divide(Position& position, int depth) const;
+
+    // The hash table, move ordering and expected reply are kept from one search to the
+    // next, so a search of the position two plies on starts with most of its work done
+    // Call this between games so nothing carries over from the last one
+    void newGame();
+
+    // Search the position to the given limits and return the main thread's best move
+    // history holds the Zobrist keys of the game's earlier positions, most recent last, so
+    // lines that repeat one of them are scored as draws
+    SearchResult search(const Position& position, const SearchLimits& limits, const std::vector<uint64_t>& history = {});
+    void stop() { _stop = true; }
+
+    // 0 uses one thread per core
+    void setThreadCount(int count);
+    int threadCount() const { return _threadCount; }
+
+    void setSearchMode(SearchMode mode) { _searchMode = mode; }
+    SearchMode searchMode() const { return _searchMode; }
+
+    void setHashSize(size_t megabytes) { _transpositionTable.resize(megabytes); }
+    const TranspositionTable& transpositionTable() const { return _transpositionTable; }
+
+    void setSearchOptions(const SearchOptions& options) { _options = options; }
+    const SearchOptions& searchOptions() const { return _options; }
+
+private:
+    struct RootMove {
+        BitMove move;
+        int score;
+        bool exact; // false if the score is only a bound because the move was searched with a narrower window
+        int pvLength = 0;
+        BitMove pv[MAX_PLY]; // line the move's score came from, starting with the move
+    };
+    static bool betterRootMove(const RootMove& a, const RootMove& b);
+    static void sortRootMoves(std::vector<RootMove>& rootMoves);
+
+    struct SearchThread {
+        int id = 0;
+        bool checksLimits = false;
+        Position position;
+        std::vector<RootMove> rootMoves;
+        std::atomic<long long> nodes{ 0 };
+        int rootDepth = 0;
+        int completedDepth = 0;
+        int bestScore = negInfinite;
+        MoveOrdering ordering;
+
+        // Triangular PV table, pv[ply] holds the best line found from ply onwards
+        BitMove pv[MAX_PLY][MAX_PLY];
+        int pvLength[MAX_PLY];
+
+        bool nullMove[MAX_PLY] = {}; // the move made at each ply was a null move
+
+        // Keys of the game's recent positions followed by the one at each ply of the
+        // current line, keys[rootKey + ply] is the position at ply
+        std::vector<uint64_t> keys;
+        int rootKey = 0;
+    };
+
+    void iterativeDeepening(SearchThread& thread);
+    void rootSplitIterativeDeepening();
+    int searchRoot(SearchThread& thread, int depth, int alpha, int beta);
+    int searchRootMove(SearchThread& thread, RootMove& rootMove, int depth, int alpha, int beta, bool fullWindow);
+    static void updatePv(SearchThread& thread, int ply, const BitMove& move);
+    bool iterationOutOfTime(std::chrono::steady_clock::time_point searchStart) const;
+    SearchResult mainThreadResult() const;
+    void reportIteration() const;
+    template <Color Us> int negamax(SearchThread& thread, int depth, int ply, int alpha, int beta);
+    template <Color Us> int quiescence(SearchThread& thread, int ply, int alpha, int beta);
+    bool countNode(SearchThread& thread);
+    void checkSearchLimits(SearchThread& thread);
+    long long totalNodes() const;
+
+    static bool hasPieces(const Position& position, int color);
+    uint64_t attackersTo(const Position& position, int square, int color, uint64_t occupancy) const;
+    template <Color Them> bool squareAttacked(const Position& position, int square, uint64_t occupancy) const;
+    template <Color Us> bool inCheck(const Position& position) const;
+    template <Color Us> uint64_t perft(Position& position, int depth) const;
+
+    // Move generation for the side to move Us, see generateAllMoves
+    template <Color Us, MoveGenType Type> void generateMoves(const Position& position, MoveList& moves) const;
+    void generateKnightMoves(MoveList& moves, BitboardElement knightBoard, uint64_t targets, uint64_t enemies) const;
+    void generateSliderMoves(MoveList& moves, BitboardElement piecesBoard, ChessPiece piece, uint64_t occupancy, uint64_t targets, uint64_t enemies, uint64_t pinned, const uint64_t* pinRays) const;
+    template <Color Us> void generateCastlingMoves(MoveList& moves, const Position& position) const;
+    template <Color Us> void generateEnPassantMoves(MoveList& moves, const Position& position, int kingSquare, uint64_t checkMask) const;
+    template <Color Us> void generatePawnMoves(MoveList& moves, uint64_t pawns, uint64_t emptySquares, uint64_t enemySquares, uint64_t pushTargets, uint64_t captureTargets) const;
+    template <int Shift> void addPawnMoves(MoveList& moves, uint64_t targets, int flags) const;
+
+    // Whether a move from somewhere else, the hash table or a killer slot, can be played here
+    template <Color Us> bool isLegal(const Position& position, const BitMove& move) const;
+    template <Color Us> class MovePicker;
+
+    int _threadCount;
+    SearchMode _searchMode;
+    SearchOptions _options;
+    std::vector<std::unique_ptr<SearchThread>> _threads;
+    std::unique_ptr<WorkStealingPool> _pool; // only for SEARCH_ROOT_SPLIT, rebuilt when the thread count changes
+
+    // Shared by every search thread
+    TranspositionTable _transpositionTable;
+    std::atomic<bool> _stop;
+    SearchLimits _limits;
+    bool _useDeadline = false;
+    std::chrono::steady_clock::time_point _searchStart;
+    std::chrono::steady_clock::time_point _searchDeadline;
+
+    // Where the last search's PV expects the game to be after its move and the reply,
+    // and the move it expects to play there, which the next search then tries first
+    uint64_t _expectedKey = 0;
+    BitMove _expectedMove;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "PieceSquare.h"
+
+//
+// Material and piece square scores, indexed by BitboardIndex (white pieces on the even
+// indexes) and square, white positive and black negative like the tables they come from
+// Every piece has a middlegame and an endgame score and the two are blended by the game
+// phase, so the pawns and king change what they want as the pieces come off
+//
+
+// Material, the same in the middlegame and the endgame
+constexpr int pieceValues[12] = { 100, -100, 300, -300, 400, -400, 500, -500, 900, -900, 2000, -2000 };
+
+// How much each piece counts towards the game phase, the starting position adds up to TOTAL_PHASE
+constexpr int phaseWeights[12] = { 0, 0, 1, 1, 1, 1, 2, 2, 4, 4, 0, 0 };
+constexpr int TOTAL_PHASE = 24;
+
+struct EvalTables {
+    int middlegame[12][64]; // material plus the piece square table
+    int endgame[12][64];
+};
+
+constexpr EvalTables buildEvalTables()
+{
+    const int* middlegame[12] = {
+        pawnTableWhite, pawnTableBlack, knightTableWhite, knightTableBlack,
+        bishopTableWhite, bishopTableBlack, rookTableWhite, rookTableBlack,
+        queenTableWhite, queenTableBlack, kingTableWhite, kingTableBlack
+    };
+    const int* endgame[12] = {
+        pawnEndTableWhite, pawnEndTableBlack, knightTableWhite, knightTableBlack,
+        bishopTableWhite, bishopTableBlack, rookTableWhite, rookTableBlack,
+        queenTableWhite, queenTableBlack, kingEndTableWhite, kingEndTableBlack
+    };
+
+    EvalTables tables{};
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            tables.middlegame[piece][square] = pieceValues[piece] + middlegame[piece][square];
+            tables.endgame[piece][square] = pieceValues[piece] + endgame[piece][square];
+        }
+    }
+    return tables;
+}
+
+inline constexpr EvalTables evalTables = buildEvalTables();
+
+// Blend the two scores, all middlegame with every piece on the board and all endgame with none
+constexpr int taperedScore(int middlegame, int endgame, int phase)
+{
+    if (phase > TOTAL_PHASE) phase = TOTAL_PHASE; // early promotions
+    return (middlegame * phase + endgame * (TOTAL_PHASE - phase)) / TOTAL_PHASE;
+}
@@ -16,11 +16,16 @@ Game::Game()
 	_gameOptions.rowY = 0;
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
+	_gameOptions.AIMAXDepth = 0;
+	_gameOptions.AITimeLimit = 0;
+	_gameOptions.AINodeLimit = 0;
+	_gameOptions.AIThreads = 0;
 	_gameOptions.AIvsAI = false;
 
 	_table = nullptr;
 	_winner = nullptr;
 	_lastMove = "";
+	_aiCancel = false;
 	// everything else
 	_dragBit = nullptr;
 	_dragMoved = false;
@@ -247,6 +252,59 @@ void Game::updateAI()
 {
 }
 
+//
+// called every frame while it is the AI's turn
+// the first call starts the search on a worker thread, later calls check if it is done
+// and make the move here on the main thread so the board is never touched by the worker
+//
+void Game::updateAsyncAI()
+{
+	if (!_aiSearch.valid())
+	{
+		_aiCancel = false;
+		prepareAISearch();
+		_aiSearch = std::async(std::launch::async, [this]() { return searchAIMove(); });
+		return;
+	}
+
+	if (_aiSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	AIMove move = _aiSearch.get();
+	if (!_aiCancel && move.from >= 0)
+	{
+		applyAIMove(move);
+	}
+}
+
+void Game::cancelAI()
+{
+	if (_aiSearch.valid())
+	{
+		_aiCancel = true;
+		_aiSearch.wait();
+		_aiSearch.get();
+	}
+	_aiCancel = false;
+}
+
+void Game::applyAIMove(const AIMove &move)
+{
+	Grid* grid = getGrid();
+	BitHolder &src = *grid->getSquareByIndex(move.from);
+	BitHolder &dst = *grid->getSquareByIndex(move.to);
+	Bit *bit = src.bit();
+	if (!bit)
+	{
+		return;
+	}
+	dst.dropBitAtPoint(bit, ImVec2(0, 0));
+	src.setBit(nullptr);
+	bitMovedFromTo(*bit, src, dst);
+}
+
 void Game::mouseDown(ImVec2 &location, Entity *entity)
 {
 	bool placing = false;
@@ -29,6 +29,13 @@ const int HUMAN_PLAYER = -1;
 
 class GameTable;
 
+// A move chosen by a background AI search, as grid square indices
+struct AIMove
+{
+	int from;
+	int to;
+};
+
 struct GameOptions
 {
 	bool AIPlaying;
@@ -39,8 +46,11 @@ struct GameOptions
 	int gameNumber;
 	unsigned int currentTurnNo;
 	int score;
-	int AIDepthSearches;
-	int AIMAXDepth;
+	int AIDepthSearches;	// iterations completed by the last iterative deepening search
+	int AIMAXDepth;		// deepest iteration to search, 0 for the game's own limit
+	int AITimeLimit;	// milliseconds per AI move, 0 for no limit
+	long long AINodeLimit;	// nodes per AI move, 0 for no limit
+	int AIThreads;		// search threads, 0 for one per core
 	bool AIvsAI;
 };
 
@@ -95,6 +105,14 @@ public:
 	virtual void stopGame() = 0;
 	virtual bool gameHasAI();
 	virtual void updateAI();
+
+	// Background AI: games that implement searchAIMove return true here and get driven
+	// through updateAsyncAI every frame instead of blocking the frame in updateAI
+	virtual bool gameHasAsyncAI() { return false; }
+	void updateAsyncAI();
+	// stop any running search and wait for the worker, its move is thrown away
+	void cancelAI();
+	bool isAIThinking() const { return _aiSearch.valid(); }
 	virtual void pieceTaken(Bit *bit){};
 
 	virtual std::string initialStateString() = 0;
@@ -138,6 +156,17 @@ public:
 	GameOptions _gameOptions;
 
 protected:
+	// Called on the main thread right before a search starts, copy whatever the search needs here
+	virtual void prepareAISearch() {}
+	// Runs on a worker thread, must only use what prepareAISearch copied and should return
+	// quickly once _aiCancel is set. A from of -1 means there is no move to make
+	virtual AIMove searchAIMove() { return { -1, -1 }; }
+	// Runs on the main thread, the default drops the bit on its new square and calls bitMovedFromTo
+	virtual void applyAIMove(const AIMove &move);
+
+	std::future<AIMove> _aiSearch;
+	std::atomic<bool> _aiCancel;
+
 	void mouseDown(ImVec2 &location, Entity *bit);
 	void mouseMoved(ImVec2 &location, Entity *bit);
 	void mouseUp(ImVec2 &location, Entity *bit);
@@ -2,9 +2,12 @@
 #define MAGIC_BITBOARDS_H
 
 #include <stdint.h>
+#include <array>
+#include <bit>
+#include <type_traits>
 
 // Generate rook attacks for a given square and blocking pieces
-static inline uint64_t ratt(int sq, uint64_t block) {
+static constexpr uint64_t ratt(int sq, uint64_t block) {
     uint64_t result = 0ULL;
     int rk = sq / 8, fl = sq % 8, r, f;
 
@@ -32,7 +35,7 @@ static inline uint64_t ratt(int sq, uint64_t block) {
 }
 
 // Generate bishop attacks for a given square and blocking pieces
-static inline uint64_t batt(int sq, uint64_t block) {
+static constexpr uint64_t batt(int sq, uint64_t block) {
     uint64_t result = 0ULL;
     int rk = sq / 8, fl = sq % 8, r, f;
 
@@ -60,8 +63,8 @@ static inline uint64_t batt(int sq, uint64_t block) {
 }
 
 // Compiler-specific bit manipulation functions
-#ifdef __clang__
-    // Clang/LLVM specific bit counting
+#if defined(__clang__) || defined(__GNUC__)
+    // GCC and Clang bit counting builtins
     static inline int countOnes(uint64_t b) {
         return __builtin_popcountll(b);
     }
@@ -81,7 +84,7 @@ static inline uint64_t batt(int sq, uint64_t block) {
         return r;
     }
 
-    // Fallback first bit implementation
+    // Fallback first bit implementation (folded 32 bit multiply, as in pop_1st_bit)
     static inline int getFirstBit(uint64_t b) {
         const int BitTable[64] = {
             63, 30, 3, 32, 25, 41, 22, 33, 15, 50, 42, 13, 11, 53, 19, 34,
@@ -89,8 +92,9 @@ static inline uint64_t batt(int sq, uint64_t block) {
             62, 31, 40, 4, 49, 5, 52, 26, 60, 6, 23, 44, 46, 27, 56, 16,
             7, 39, 48, 24, 59, 14, 12, 55, 38, 28, 58, 20, 37, 17, 36, 8
         };
-        uint64_t debruijn = 0x03f79d71b4cb0a89ULL;
-        return BitTable[((b ^ (b-1)) * debruijn) >> 58];
+        b ^= b - 1;
+        unsigned int folded = (unsigned int)(b ^ (b >> 32));
+        return BitTable[(folded * 0x783A9B23u) >> 26];
     }
 #endif
 
@@ -128,7 +132,7 @@ static inline uint64_t indexToUint64(int index, int bits, uint64_t m) {
 #define BLACK_PAWN_ATTACKS(pawns) (SOUTH_EAST(pawns) | SOUTH_WEST(pawns))
 
 // Size of attack tables for each square
-const int RAttackSize[64] = {
+constexpr int RAttackSize[64] = {
   4096,
   2048,
   2048,
@@ -195,7 +199,7 @@ const int RAttackSize[64] = {
   4096,
 };
 
-const int BAttackSize[64] = {
+constexpr int BAttackSize[64] = {
   64,
   32,
   32,
@@ -262,283 +266,8 @@ const int BAttackSize[64] = {
   64,
 };
 
-// Attack lookup tables
-static uint64_t* RAttacks[64];
-static uint64_t* BAttacks[64];
-
-// Magic bitboard shift amounts
-const int RShifts[64] = {
-  52,
-  53,
-  53,
-  53,
-  53,
-  53,
-  53,
-  52,
-  53,
-  54,
-  54,
-  54,
-  54,
-  54,
-  54,
-  53,
-  53,
-  54,
-  54,
-  54,
-  54,
-  54,
-  54,
-  53,
-  53,
-  54,
-  54,
-  54,
-  54,
-  54,
-  54,
-  53,
-  53,
-  54,
-  54,
-  54,
-  54,
-  54,
-  54,
-  53,
-  53,
-  54,
-  54,
-  54,
-  54,
-  54,
-  54,
-  53,
-  53,
-  54,
-  54,
-  54,
-  54,
-  54,
-  54,
-  53,
-  52,
-  53,
-  53,
-  53,
-  53,
-  53,
-  53,
-  52,
-};
-
-const int BShifts[64] = {
-  58,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  58,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  57,
-  57,
-  57,
-  57,
-  59,
-  59,
-  59,
-  59,
-  57,
-  55,
-  55,
-  57,
-  59,
-  59,
-  59,
-  59,
-  57,
-  55,
-  55,
-  57,
-  59,
-  59,
-  59,
-  59,
-  57,
-  57,
-  57,
-  57,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  58,
-  59,
-  59,
-  59,
-  59,
-  59,
-  59,
-  58,
-};
-
-// Magic numbers for rooks
-const uint64_t RMagic[64] = {
-  0xa8002c000108020ULL,
-  0x6c00049b0002001ULL,
-  0x100200010090040ULL,
-  0x2480041000800801ULL,
-  0x280028004000800ULL,
-  0x900410008040022ULL,
-  0x280020001001080ULL,
-  0x2880002041000080ULL,
-  0xa000800080400034ULL,
-  0x4808020004000ULL,
-  0x2290802004801000ULL,
-  0x411000d00100020ULL,
-  0x402800800040080ULL,
-  0xb000401004208ULL,
-  0x2409000100040200ULL,
-  0x1002100004082ULL,
-  0x22878001e24000ULL,
-  0x1090810021004010ULL,
-  0x801030040200012ULL,
-  0x500808008001000ULL,
-  0xa08018014000880ULL,
-  0x8000808004000200ULL,
-  0x201008080010200ULL,
-  0x801020000441091ULL,
-  0x800080204005ULL,
-  0x1040200040100048ULL,
-  0x120200402082ULL,
-  0xd14880480100080ULL,
-  0x12040280080080ULL,
-  0x100040080020080ULL,
-  0x9020010080800200ULL,
-  0x813241200148449ULL,
-  0x491604001800080ULL,
-  0x100401000402001ULL,
-  0x4820010021001040ULL,
-  0x400402202000812ULL,
-  0x209009005000802ULL,
-  0x810800601800400ULL,
-  0x4301083214000150ULL,
-  0x204026458e001401ULL,
-  0x40204000808000ULL,
-  0x8001008040010020ULL,
-  0x8410820820420010ULL,
-  0x1003001000090020ULL,
-  0x804040008008080ULL,
-  0x12000810020004ULL,
-  0x1000100200040208ULL,
-  0x430000a044020001ULL,
-  0x280009023410300ULL,
-  0xe0100040002240ULL,
-  0x200100401700ULL,
-  0x2244100408008080ULL,
-  0x8000400801980ULL,
-  0x2000810040200ULL,
-  0x8010100228810400ULL,
-  0x2000009044210200ULL,
-  0x4080008040102101ULL,
-  0x40002080411d01ULL,
-  0x2005524060000901ULL,
-  0x502001008400422ULL,
-  0x489a000810200402ULL,
-  0x1004400080a13ULL,
-  0x4000011008020084ULL,
-  0x26002114058042ULL,
-};
-
-// Magic numbers for bishops
-const uint64_t BMagic[64] = {
-  0x89a1121896040240ULL,
-  0x2004844802002010ULL,
-  0x2068080051921000ULL,
-  0x62880a0220200808ULL,
-  0x4042004000000ULL,
-  0x100822020200011ULL,
-  0xc00444222012000aULL,
-  0x28808801216001ULL,
-  0x400492088408100ULL,
-  0x201c401040c0084ULL,
-  0x840800910a0010ULL,
-  0x82080240060ULL,
-  0x2000840504006000ULL,
-  0x30010c4108405004ULL,
-  0x1008005410080802ULL,
-  0x8144042209100900ULL,
-  0x208081020014400ULL,
-  0x4800201208ca00ULL,
-  0xf18140408012008ULL,
-  0x1004002802102001ULL,
-  0x841000820080811ULL,
-  0x40200200a42008ULL,
-  0x800054042000ULL,
-  0x88010400410c9000ULL,
-  0x520040470104290ULL,
-  0x1004040051500081ULL,
-  0x2002081833080021ULL,
-  0x400c00c010142ULL,
-  0x941408200c002000ULL,
-  0x658810000806011ULL,
-  0x188071040440a00ULL,
-  0x4800404002011c00ULL,
-  0x104442040404200ULL,
-  0x511080202091021ULL,
-  0x4022401120400ULL,
-  0x80c0040400080120ULL,
-  0x8040010040820802ULL,
-  0x480810700020090ULL,
-  0x102008e00040242ULL,
-  0x809005202050100ULL,
-  0x8002024220104080ULL,
-  0x431008804142000ULL,
-  0x19001802081400ULL,
-  0x200014208040080ULL,
-  0x3308082008200100ULL,
-  0x41010500040c020ULL,
-  0x4012020c04210308ULL,
-  0x208220a202004080ULL,
-  0x111040120082000ULL,
-  0x6803040141280a00ULL,
-  0x2101004202410000ULL,
-  0x8200000041108022ULL,
-  0x21082088000ULL,
-  0x2410204010040ULL,
-  0x40100400809000ULL,
-  0x822088220820214ULL,
-  0x40808090012004ULL,
-  0x910224040218c9ULL,
-  0x402814422015008ULL,
-  0x90014004842410ULL,
-  0x1000042304105ULL,
-  0x10008830412a00ULL,
-  0x2520081090008908ULL,
-  0x40102000a0a60140ULL,
-};
-
 // Attack masks for each square
-const uint64_t RMasks[64] = {
+constexpr uint64_t RMasks[64] = {
   0x101010101017eULL,
   0x202020202027cULL,
   0x404040404047aULL,
@@ -605,7 +334,7 @@ const uint64_t RMasks[64] = {
   0x7e80808080808000ULL,
 };
 
-const uint64_t BMasks[64] = {
+constexpr uint64_t BMasks[64] = {
   0x40201008040200ULL,
   0x402010080400ULL,
   0x4020100a00ULL,
@@ -673,7 +402,7 @@ const uint64_t BMasks[64] = {
 };
 
 // Pre-calculated knight attack bitboards
-const uint64_t KnightAttacks[64] = {
+constexpr uint64_t KnightAttacks[64] = {
   0x20400ULL,
   0x50800ULL,
   0xa1100ULL,
@@ -741,7 +470,7 @@ const uint64_t KnightAttacks[64] = {
 };
 
 // Pre-calculated king attack bitboards
-const uint64_t KingAttacks[64] = {
+constexpr uint64_t KingAttacks[64] = {
   0x302ULL,
   0x705ULL,
   0xe0aULL,
@@ -808,66 +537,248 @@ const uint64_t KingAttacks[64] = {
   0x40c0000000000000ULL,
 };
 
-// Helper functions for move generation
-static inline uint64_t getRookAttacks(int square, uint64_t occupied) {
-    occupied &= RMasks[square];
-    occupied *= RMagic[square];
-    occupied >>= RShifts[square];
-    return RAttacks[square][occupied];
+// Squares a slider on each square sees in each direction on an empty board, first the four
+// that go up the board (north, east, north east, north west) and then the four going down
+constexpr int RayStep[8][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 }, { -1, 0 }, { 0, -1 }, { -1, -1 }, { -1, 1 } };
+
+struct RayTable {
+    uint64_t rays[8][64];
+};
+
+constexpr RayTable buildRays() {
+    RayTable table{};
+    for (int direction = 0; direction < 8; direction++) {
+        for (int square = 0; square < 64; square++) {
+            uint64_t ray = 0;
+            for (int rank = square / 8 + RayStep[direction][0], file = square % 8 + RayStep[direction][1];
+                 rank >= 0 && rank <= 7 && file >= 0 && file <= 7;
+                 rank += RayStep[direction][0], file += RayStep[direction][1]) {
+                ray |= 1ULL << (rank * 8 + file);
+            }
+            table.rays[direction][square] = ray;
+        }
+    }
+    return table;
+}
+
+constexpr RayTable Rays = buildRays();
+
+// A ray stops at the first blocker, which is the lowest set bit going up the board and the
+// highest going down. Cheaper than stepping square by square, which matters at compile time
+constexpr uint64_t rayAttacks(int direction, int square, uint64_t occupied) {
+    uint64_t ray = Rays.rays[direction][square];
+    const uint64_t blockers = ray & occupied;
+    if (blockers) {
+        const int blocker = direction < 4 ? std::countr_zero(blockers) : 63 - std::countl_zero(blockers);
+        ray ^= Rays.rays[direction][blocker];
+    }
+    return ray;
 }
 
-static inline uint64_t getBishopAttacks(int square, uint64_t occupied) {
-    occupied &= BMasks[square];
-    occupied *= BMagic[square];
-    occupied >>= BShifts[square];
-    return BAttacks[square][occupied];
+//
+// Attack lookup tables, filled in at compile time so they sit in read-only memory and
+// there is nothing to set up or free at run time
+// A magic index picks a slot holding the attack set itself, so a lookup is a single load.
+// Every square's table (2^bits slots, see RAttackSize and BAttackSize) overlaps the others
+// wherever its magic leaves slots unused, the magics and where each table starts come
+// from tools/magic_gen.cpp
+// Slots could hold 16 bit references into a list of the distinct attack sets instead,
+// which is a third of the size, but the second load that takes is a second cache miss
+// once transposition table probes have pushed the tables out, see bench/bench_magic.cpp
+//
+
+// Rooks use the directions 0, 1, 4 and 5 and bishops 2, 3, 6 and 7, see RayStep
+constexpr bool rookDirection(int direction) {
+    return (direction & 2) == 0;
 }
 
-static inline uint64_t getQueenAttacks(int square, uint64_t occupied) {
-    return getRookAttacks(square, occupied) | getBishopAttacks(square, occupied);
+constexpr uint64_t sliderAttacks(int square, bool rook, uint64_t occupied) {
+    uint64_t attacks = 0;
+    for (int direction = 0; direction < 8; direction++) {
+        if (rookDirection(direction) == rook) attacks |= rayAttacks(direction, square, occupied);
+    }
+    return attacks;
 }
 
-// Initialize magic bitboards
-void initMagicBitboards(void) {
-    int square, i;
-    uint64_t subset, index;
-
-    // Initialize rook attack tables
-    for (square = 0; square < 64; square++) {
-        RAttacks[square] = new uint64_t[RAttackSize[square]];
-        uint64_t mask = RMasks[square];
-        int bits = countOnes(mask);
-        int n = 1 << bits;
-
-        for (i = 0; i < n; i++) {
-            subset = indexToUint64(i, bits, mask);
-            index = (subset * RMagic[square]) >> RShifts[square];
-            RAttacks[square][index] = ratt(square, subset);
-        }
+// The generator only needs what's above, it writes the header below
+#ifndef MAGIC_GENERATOR
+
+#include "MagicTables.h"
+
+// Tables indexed with BMI2's PEXT, which packs the blockers under the mask into the low
+// bits directly, so every square's table is exactly 2^bits slots with none unused and they
+// sit back to back
+struct PextOffsets {
+    int rook[64];
+    int bishop[64];
+    int total;
+};
+
+constexpr PextOffsets buildPextOffsets() {
+    PextOffsets offsets{};
+    int next = 0;
+    for (int square = 0; square < 64; square++) {
+        offsets.rook[square] = next;
+        next += RAttackSize[square];
+        offsets.bishop[square] = next;
+        next += BAttackSize[square];
     }
+    offsets.total = next;
+    return offsets;
+}
+
+constexpr PextOffsets PextOffset = buildPextOffsets();
+
+struct SliderAttackTable {
+    uint64_t attacks[SliderAttackTableSize];
+    uint64_t pextAttacks[PextOffset.total];
+};
+
+// Magic index for each piece, "black magic" style: the bits outside the mask are set
+// rather than cleared, which lets a magic leave more of its table unused for others
+constexpr uint64_t rookIndex(int square, uint64_t occupied) {
+    return ((occupied | ~RMasks[square]) * RMagic[square]) >> RShifts[square];
+}
+
+constexpr uint64_t bishopIndex(int square, uint64_t occupied) {
+    return ((occupied | ~BMasks[square]) * BMagic[square]) >> BShifts[square];
+}
 
-    // Initialize bishop attack tables
-    for (square = 0; square < 64; square++) {
-        BAttacks[square] = new uint64_t[BAttackSize[square]];
-        uint64_t mask = BMasks[square];
-        int bits = countOnes(mask);
-        int n = 1 << bits;
-
-        for (i = 0; i < n; i++) {
-            subset = indexToUint64(i, bits, mask);
-            index = (subset * BMagic[square]) >> BShifts[square];
-            BAttacks[square][index] = batt(square, subset);
+// Every subset of each square's mask (walked with the carry-rippler trick) puts its
+// attack set in the slot its magic index picks. A slider always attacks something, so
+// an empty slot is 0, and overlapping tables may only meet on empty slots or on slots
+// that want the same attack set, anything else stops the compile
+// The carry-rippler counts through the subsets in the same order PEXT numbers them, so
+// the PEXT tables just take the attack sets in turn
+constexpr SliderAttackTable buildSliderAttacks() {
+    SliderAttackTable table{};
+    for (int square = 0; square < 64; square++) {
+        for (int piece = 0; piece < 2; piece++) {
+            const bool rook = piece == 0;
+            const uint64_t mask = rook ? RMasks[square] : BMasks[square];
+            int pextSlot = rook ? PextOffset.rook[square] : PextOffset.bishop[square];
+            uint64_t subset = 0;
+            do {
+                const int slot = rook ? RAttackOffset[square] + static_cast<int>(rookIndex(square, subset))
+                                      : BAttackOffset[square] + static_cast<int>(bishopIndex(square, subset));
+                const uint64_t attacks = sliderAttacks(square, rook, subset);
+                if (table.attacks[slot] != 0 && table.attacks[slot] != attacks) {
+                    throw "magic tables collide, regenerate MagicTables.h";
+                }
+                table.attacks[slot] = attacks;
+                table.pextAttacks[pextSlot++] = attacks;
+                subset = (subset - mask) & mask;
+            } while (subset);
         }
     }
+    return table;
+}
+
+alignas(64) static constexpr SliderAttackTable SliderAttacks = buildSliderAttacks();
+
+//
+// Slider attack backends
+// PEXT turns the multiply and shift of a magic index into one instruction where the CPU
+// has BMI2. AMD's Zen 1 and Zen 2 do have it, but microcoded and far slower than a
+// multiply, so those keep the magics, as does anything else without BMI2
+// The choice is made once at startup and is one well predicted branch in each lookup,
+// PEXT goes through inline assembly so the rest of the engine doesn't need BMI2 to build
+//
+
+enum SliderBackend
+{
+    SLIDER_MAGIC,
+    SLIDER_PEXT,
+    SLIDER_BEST // PEXT where it's fast, magics everywhere else
+};
+
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) || (defined(_MSC_VER) && defined(_M_X64))
+#define SLIDER_PEXT_AVAILABLE 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+static inline uint64_t pext(uint64_t bits, uint64_t mask) {
+#if defined(SLIDER_PEXT_AVAILABLE) && defined(_MSC_VER)
+    return _pext_u64(bits, mask);
+#elif defined(SLIDER_PEXT_AVAILABLE)
+    uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(bits), "r"(mask));
+    return result;
+#else
+    return 0;
+#endif
+}
+
+// Whether the backend was compiled in and the CPU can run it at full speed
+inline bool sliderBackendSupported(SliderBackend backend) {
+    switch (backend) {
+    case SLIDER_MAGIC:
+    case SLIDER_BEST:
+        return true;
+#if defined(SLIDER_PEXT_AVAILABLE) && defined(_MSC_VER)
+    case SLIDER_PEXT: {
+        int info[4];
+        __cpuid(info, 0);
+        const bool amd = info[1] == 0x68747541; // "Auth"enticAMD
+        __cpuid(info, 1);
+        const int family = ((info[0] >> 8) & 0xF) + ((info[0] >> 20) & 0xFF);
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 8)) != 0 && !(amd && family == 0x17);
+    }
+#elif defined(SLIDER_PEXT_AVAILABLE)
+    // Can run before main, so make sure the CPU info is filled in
+    case SLIDER_PEXT:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+#endif
+    default:
+        return false;
+    }
 }
 
-// Cleanup magic bitboard tables
-void cleanupMagicBitboards(void) {
-    int square;
-    for (square = 0; square < 64; square++) {
-        delete[] RAttacks[square];
-        delete[] BAttacks[square];
+inline const char* sliderBackendName(SliderBackend backend) {
+    switch (backend) {
+    case SLIDER_MAGIC: return "magic";
+    case SLIDER_PEXT: return "pext";
+    default: return "best";
     }
 }
 
+inline bool SliderUsePext = sliderBackendSupported(SLIDER_PEXT);
+
+// Switches every lookup over to the backend, false if this CPU can't run it
+inline bool setSliderBackend(SliderBackend backend) {
+    if (!sliderBackendSupported(backend)) return false;
+    SliderUsePext = backend == SLIDER_PEXT || (backend == SLIDER_BEST && sliderBackendSupported(SLIDER_PEXT));
+    return true;
+}
+
+inline SliderBackend sliderBackend() {
+    return SliderUsePext ? SLIDER_PEXT : SLIDER_MAGIC;
+}
+
+// Helper functions for move generation
+static constexpr uint64_t getRookAttacks(int square, uint64_t occupied) {
+    if (!std::is_constant_evaluated() && SliderUsePext) {
+        return SliderAttacks.pextAttacks[PextOffset.rook[square] + pext(occupied, RMasks[square])];
+    }
+    return SliderAttacks.attacks[RAttackOffset[square] + rookIndex(square, occupied)];
+}
+
+static constexpr uint64_t getBishopAttacks(int square, uint64_t occupied) {
+    if (!std::is_constant_evaluated() && SliderUsePext) {
+        return SliderAttacks.pextAttacks[PextOffset.bishop[square] + pext(occupied, BMasks[square])];
+    }
+    return SliderAttacks.attacks[BAttackOffset[square] + bishopIndex(square, occupied)];
+}
+
+static constexpr uint64_t getQueenAttacks(int square, uint64_t occupied) {
+    return getRookAttacks(square, occupied) | getBishopAttacks(square, occupied);
+}
+
+#endif // MAGIC_GENERATOR
+
 #endif // MAGIC_BITBOARDS_H
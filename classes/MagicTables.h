@@ -0,0 +1,421 @@
+//
+// Generated by chess_magic_gen (tools/magic_gen.cpp) with 20000000 candidates per square
+// and seed 20240601, don't edit by hand. The rook and bishop tables overlap in one
+// array of SliderAttackTableSize entries, each square's index is added to its offset.
+//
+#ifndef MAGIC_TABLES_H
+#define MAGIC_TABLES_H
+
+#include <stdint.h>
+
+constexpr int SliderAttackTableSize = 103041;
+
+// Magic bitboard shift amounts
+constexpr int RShifts[64] = {
+  52,
+  53,
+  53,
+  53,
+  53,
+  53,
+  53,
+  52,
+  53,
+  54,
+  54,
+  54,
+  54,
+  54,
+  54,
+  53,
+  53,
+  54,
+  54,
+  54,
+  54,
+  54,
+  54,
+  53,
+  53,
+  54,
+  54,
+  54,
+  54,
+  54,
+  54,
+  53,
+  53,
+  54,
+  54,
+  54,
+  54,
+  54,
+  54,
+  53,
+  53,
+  54,
+  54,
+  54,
+  54,
+  54,
+  54,
+  53,
+  53,
+  54,
+  54,
+  54,
+  54,
+  54,
+  54,
+  53,
+  52,
+  53,
+  53,
+  53,
+  53,
+  53,
+  53,
+  52,
+};
+
+// Where each square's rook table starts in the shared array
+constexpr int RAttackOffset[64] = {
+  0,
+  36157,
+  18388,
+  34114,
+  46382,
+  20435,
+  44336,
+  4091,
+  28017,
+  83825,
+  92461,
+  95524,
+  77694,
+  86622,
+  82803,
+  40247,
+  26141,
+  90420,
+  79737,
+  78714,
+  65430,
+  74626,
+  73603,
+  22482,
+  32067,
+  80761,
+  64406,
+  69515,
+  70538,
+  71557,
+  72580,
+  16341,
+  30030,
+  91440,
+  66449,
+  81779,
+  75647,
+  76670,
+  87635,
+  38203,
+  24357,
+  94505,
+  84842,
+  93483,
+  67471,
+  68494,
+  89480,
+  42293,
+  54293,
+  99259,
+  97449,
+  88650,
+  96547,
+  98403,
+  85634,
+  56311,
+  12245,
+  58332,
+  60345,
+  62359,
+  50466,
+  52494,
+  48424,
+  8179,
+};
+
+// Magic numbers for rooks
+constexpr uint64_t RMagic[64] = {
+  0x0080001682400008ULL,
+  0x085804020014000aULL,
+  0x09000b0040052000ULL,
+  0x1080100180d80002ULL,
+  0x0100029288000100ULL,
+  0x0200020010880084ULL,
+  0x840001eb10000801ULL,
+  0x1408020025840008ULL,
+  0x0400300088001800ULL,
+  0x1400b00a10400008ULL,
+  0x4002001263420008ULL,
+  0x30020009c2920002ULL,
+  0x2800c00600024024ULL,
+  0x0046000230c60001ULL,
+  0x00440008a1100044ULL,
+  0x2015100050440002ULL,
+  0x018000300218001aULL,
+  0x0040012008100009ULL,
+  0x0400820018420006ULL,
+  0x1805010024300004ULL,
+  0x0208110008010003ULL,
+  0x2012020002c81001ULL,
+  0x2822940001300048ULL,
+  0x41030a0000640021ULL,
+  0x9202008400410400ULL,
+  0x4042010400840040ULL,
+  0xc10420010043000cULL,
+  0x40003001001d0004ULL,
+  0x0000010300080070ULL,
+  0xa000010100040008ULL,
+  0x8004009080320905ULL,
+  0x0000800480124100ULL,
+  0x8804020104004080ULL,
+  0x000003102e400040ULL,
+  0x0000084107002004ULL,
+  0x0900050221001000ULL,
+  0x008002001a00200cULL,
+  0x2200080101000400ULL,
+  0x0000002041a01008ULL,
+  0x8000001024100741ULL,
+  0x0280000818003000ULL,
+  0x1000054430094000ULL,
+  0x04000a0401242000ULL,
+  0x2000020a02420018ULL,
+  0x401002000c060020ULL,
+  0x3000040001010048ULL,
+  0x100000402002a010ULL,
+  0x0050000900089001ULL,
+  0x00000a0904080190ULL,
+  0x0000010e300040c0ULL,
+  0x0a400502401800c0ULL,
+  0x1b00042228101a00ULL,
+  0x02000114e0100a00ULL,
+  0x009000e22c402020ULL,
+  0x06800040201002a0ULL,
+  0x4420000906c11020ULL,
+  0x000000401420811aULL,
+  0x4100044910201082ULL,
+  0x0000051080202842ULL,
+  0x00000108c4100422ULL,
+  0x0112000002044892ULL,
+  0xc82600000281044aULL,
+  0x30020000051104e2ULL,
+  0x0001000010884125ULL,
+};
+
+// Magic bitboard shift amounts
+constexpr int BShifts[64] = {
+  58,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  58,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  57,
+  57,
+  57,
+  57,
+  59,
+  59,
+  59,
+  59,
+  57,
+  55,
+  55,
+  57,
+  59,
+  59,
+  59,
+  59,
+  57,
+  55,
+  55,
+  57,
+  59,
+  59,
+  59,
+  59,
+  57,
+  57,
+  57,
+  57,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  58,
+  59,
+  59,
+  59,
+  59,
+  59,
+  59,
+  58,
+};
+
+// Where each square's bishop table starts in the shared array
+constexpr int BAttackOffset[64] = {
+  29165,
+  14982,
+  13512,
+  12877,
+  12498,
+  13639,
+  14406,
+  29200,
+  14470,
+  14535,
+  13767,
+  12685,
+  12621,
+  14152,
+  14600,
+  14727,
+  13964,
+  13384,
+  25351,
+  28944,
+  29070,
+  102329,
+  13832,
+  13325,
+  13260,
+  13198,
+  102675,
+  101306,
+  100795,
+  27266,
+  13139,
+  12433,
+  13072,
+  12366,
+  78558,
+  100283,
+  101818,
+  27146,
+  12306,
+  13008,
+  14216,
+  13456,
+  102914,
+  102447,
+  102802,
+  102557,
+  14279,
+  13900,
+  14854,
+  14790,
+  14023,
+  12753,
+  12817,
+  14095,
+  15054,
+  14662,
+  25444,
+  14342,
+  13710,
+  12565,
+  12937,
+  13576,
+  14922,
+  25483,
+};
+
+// Magic numbers for bishops
+constexpr uint64_t BMagic[64] = {
+  0x0008028194010801ULL,
+  0x0242240122180020ULL,
+  0x000811b10410a400ULL,
+  0x0086186008400c01ULL,
+  0x2c01858200003101ULL,
+  0x0001214881084001ULL,
+  0x004100a211008020ULL,
+  0x0800203202100089ULL,
+  0x0042200282025005ULL,
+  0x0802050820910806ULL,
+  0x00842420a890084cULL,
+  0x0014461868090000ULL,
+  0x0320018582008010ULL,
+  0x002824a144818401ULL,
+  0x12020044220880a1ULL,
+  0x08200042008480c4ULL,
+  0x7254000842048012ULL,
+  0x0004041043421024ULL,
+  0x088c010602981804ULL,
+  0x000c001804180502ULL,
+  0x0880c00061005044ULL,
+  0x100c600030100058ULL,
+  0x00a2800080a40141ULL,
+  0x0001a00029812080ULL,
+  0x00080800214ea088ULL,
+  0x100c0c0244418030ULL,
+  0x0044020010087004ULL,
+  0xa001004014040200ULL,
+  0x0210010180200800ULL,
+  0x0008006000302008ULL,
+  0x21028c0080612041ULL,
+  0x820500c0c030c040ULL,
+  0x1400522080100401ULL,
+  0x0890460348460c25ULL,
+  0x04000a2808100080ULL,
+  0x4008018180080200ULL,
+  0x400c001008020080ULL,
+  0x0020002030006806ULL,
+  0x8800c3005020ca00ULL,
+  0x0880105052020144ULL,
+  0x0d20210410402400ULL,
+  0x410002631002c400ULL,
+  0x8208011804110201ULL,
+  0x2008400414080800ULL,
+  0x0440004110604400ULL,
+  0x100044c050c02180ULL,
+  0x0000412240966240ULL,
+  0x20800140408d8140ULL,
+  0x0000010149208082ULL,
+  0x0100004404450200ULL,
+  0x002804085124305cULL,
+  0x2108000018460420ULL,
+  0x4020000085414100ULL,
+  0x400080c841812100ULL,
+  0x4000104401684242ULL,
+  0x01c1082081084008ULL,
+  0x0100010082412004ULL,
+  0x0100001080a80804ULL,
+  0x8060000410909408ULL,
+  0x4139020000184602ULL,
+  0x0000001000854140ULL,
+  0x0008008112a240a0ULL,
+  0x200402102202005aULL,
+  0x1000900421006c21ULL,
+};
+
+#endif // MAGIC_TABLES_H
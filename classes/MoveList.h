@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Bitboard.h"
+
+// No legal chess position has more than 218 moves
+constexpr int MAX_MOVES = 256;
+
+//
+// Fixed capacity move list that lives on the stack, so generating moves in the search
+// never touches the heap. The moves are left uninitialized until they are added.
+//
+struct MoveList {
+    union {
+        BitMove moves[MAX_MOVES];
+    };
+    int count;
+
+    MoveList() : count(0) { }
+
+    void emplace_back(int from, int to, int flags = QUIET_MOVE) { moves[count++] = BitMove(from, to, flags); }
+    void push_back(const BitMove& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    BitMove& operator[](int index) { return moves[index]; }
+    const BitMove& operator[](int index) const { return moves[index]; }
+
+    BitMove* begin() { return moves; }
+    BitMove* end() { return moves + count; }
+    const BitMove* begin() const { return moves; }
+    const BitMove* end() const { return moves + count; }
+};
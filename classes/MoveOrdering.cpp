@@ -0,0 +1,118 @@
+#include "MoveOrdering.h"
+#include <cstdlib>
+#include <utility>
+
+// Bands so that each kind of move always sorts ahead of the next
+constexpr int TT_MOVE_SCORE = 1000000;
+constexpr int CAPTURE_SCORE = 500000;
+constexpr int KILLER_SCORE = 400000;
+
+// History scores stay within +-HISTORY_MAX, below the killer band
+constexpr int HISTORY_MAX = 16384;
+
+void MoveOrdering::clear()
+{
+    for (auto& plyKillers : killers) {
+        plyKillers[0] = BitMove();
+        plyKillers[1] = BitMove();
+    }
+    for (auto& color : history) {
+        for (auto& from : color) {
+            for (auto& score : from) {
+                score = 0;
+            }
+        }
+    }
+    betaCutoffs = 0;
+    firstMoveCutoffs = 0;
+}
+
+void MoveOrdering::newSearch()
+{
+    for (int ply = 0; ply < MAX_PLY; ply++) {
+        killers[ply][0] = ply + 2 < MAX_PLY ? killers[ply + 2][0] : BitMove();
+        killers[ply][1] = ply + 2 < MAX_PLY ? killers[ply + 2][1] : BitMove();
+    }
+    for (auto& color : history) {
+        for (auto& from : color) {
+            for (auto& score : from) {
+                score /= 2;
+            }
+        }
+    }
+    betaCutoffs = 0;
+    firstMoveCutoffs = 0;
+}
+
+void MoveOrdering::scoreMoves(const Position& position, const MoveList& moves, const BitMove& ttMove, int ply, int* scores) const
+{
+    const BitMove* plyKillers = killersAt(ply);
+    const int color = position.sideToMove;
+
+    for (int i = 0; i < moves.size(); i++) {
+        const BitMove& move = moves[i];
+        if (move == ttMove) {
+            scores[i] = TT_MOVE_SCORE;
+        }
+        else if (move.isCapture() || move.isPromotion()) {
+            // Most valuable victim, least valuable attacker, the type numbers run pawn to king
+            const int captured = position.capturedPiece(move);
+            const int victim = captured != EMPTY_SQUARES ? (captured >> 1) + 1 : Pawn;
+            const int attacker = (position.movedPiece(move) >> 1) + 1;
+            scores[i] = CAPTURE_SCORE + victim * 64 + move.promotion() * 8 - attacker;
+        }
+        else if (move == plyKillers[0]) {
+            scores[i] = KILLER_SCORE + 1;
+        }
+        else if (move == plyKillers[1]) {
+            scores[i] = KILLER_SCORE;
+        }
+        else {
+            scores[i] = history[color][move.from()][move.to()];
+        }
+    }
+}
+
+void MoveOrdering::pickNext(MoveList& moves, int* scores, int index)
+{
+    int best = index;
+    for (int i = index + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    if (best != index) {
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+    }
+}
+
+// Move a history score towards +-HISTORY_MAX, less the closer it already is, so the
+// scores never overflow and recent cutoffs count for more than old ones
+static void updateHistory(int& score, int bonus)
+{
+    score += bonus - score * std::abs(bonus) / HISTORY_MAX;
+}
+
+void MoveOrdering::cutoff(const Position& position, const BitMove& move, int depth, int ply, int moveIndex, const MoveList& quiets)
+{
+    betaCutoffs++;
+    if (moveIndex == 0) {
+        firstMoveCutoffs++;
+    }
+
+    // Captures are already ordered by MVV-LVA
+    if (move.isCapture() || move.isPromotion()) return;
+
+    if (ply < MAX_PLY && !(killers[ply][0] == move)) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    const int color = position.sideToMove;
+    const int bonus = depth * depth < HISTORY_MAX ? depth * depth : HISTORY_MAX;
+    updateHistory(history[color][move.from()][move.to()], bonus);
+    for (const BitMove& quiet : quiets) {
+        updateHistory(history[color][quiet.from()][quiet.to()], -bonus);
+    }
+}
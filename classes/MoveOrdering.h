@@ -0,0 +1,44 @@
+#pragma once
+
+#include "MoveList.h"
+#include "Position.h"
+
+constexpr int MAX_PLY = 128; // deepest ply the killer table keeps moves for
+
+//
+// Scores moves so the ones most likely to cause a cutoff are searched first:
+//  1. the hash table's best move from an earlier search of the position
+//  2. captures and promotions, most valuable victim first, then least valuable attacker
+//  3. the two killer moves for the ply, quiet moves that caused a cutoff in a sibling
+//  4. everything else by history, how often the move caused a cutoff anywhere in the tree
+// Each search thread has its own, so nothing here needs to be thread safe
+// It is kept from one search to the next within a game, see newSearch
+//
+struct MoveOrdering {
+    BitMove killers[MAX_PLY][2];
+    int history[2][64][64]; // [color][from][to]
+
+    // Cutoff statistics, a well ordered search gets most of its cutoffs from the first move
+    long long betaCutoffs = 0;
+    long long firstMoveCutoffs = 0;
+
+    MoveOrdering() { clear(); }
+
+    void clear();
+    // The next search starts two plies further into the game, so the killers move up two
+    // plies to stay with the positions they came from, and the history is halved so it
+    // follows the new position more than the old one
+    void newSearch();
+
+    void scoreMoves(const Position& position, const MoveList& moves, const BitMove& ttMove, int ply, int* scores) const;
+
+    // The two killer moves for the ply, either can be empty
+    const BitMove* killersAt(int ply) const { return killers[ply < MAX_PLY ? ply : MAX_PLY - 1]; }
+
+    // Swap the best scoring move from index on into index
+    static void pickNext(MoveList& moves, int* scores, int index);
+
+    // Record a beta cutoff caused by the move searched moveIndex'th, quiets are the quiet
+    // moves that were searched before it without causing one
+    void cutoff(const Position& position, const BitMove& move, int depth, int ply, int moveIndex, const MoveList& quiets);
+};
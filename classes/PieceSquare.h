@@ -1,9 +1,11 @@
+#pragma once
+
 
 // Piece square tables for every piece (from chess programming wiki)
 // Our state string goes from bottom left to top right, so white tables are flipped
 // Our eval function evalutes for white, so all black values are negated
 
-const int pawnTableBlack[64] = {
+constexpr int pawnTableBlack[64] = {
     0, 0, 0, 0, 0, 0, 0, 0,
     -50, -50, -50, -50, -50, -50, -50, -50,
     -10, -10, -20, -30, -30, -20, -10, -10,
@@ -14,7 +16,7 @@ const int pawnTableBlack[64] = {
     0, 0, 0, 0, 0, 0, 0, 0
 };
 
-const int pawnTableWhite[64] = {
+constexpr int pawnTableWhite[64] = {
     0, 0, 0, 0, 0, 0, 0, 0,
     5, 10, 10, -20, -20, 10, 10, 5,
     5, -5, -10, 0, 0, -10, -5, 5,
@@ -25,7 +27,7 @@ const int pawnTableWhite[64] = {
     0, 0, 0, 0, 0, 0, 0, 0
 };
 
-const int knightTableBlack[64] = {
+constexpr int knightTableBlack[64] = {
     50, 40, 30, 30, 30, 30, 40, 50,
     40, 20, 0, 0, 0, 0, 20, 40,
     30, 0, -10, -15, -15, -10, 0, 30,
@@ -36,7 +38,7 @@ const int knightTableBlack[64] = {
     50, 40, 30, 30, 30, 30, 40, 50
 };
 
-const int knightTableWhite[64] = {
+constexpr int knightTableWhite[64] = {
     -50, -40, -30, -30, -30, -30, -40, -50,
     -40, -20, 0, 5, 5, 0, -20, -40,
     -30, 5, 10, 15, 15, 10, 5, -30,
@@ -47,7 +49,7 @@ const int knightTableWhite[64] = {
     -50, -40, -30, -30, -30, -30, -40, -50
 };
 
-const int bishopTableBlack[64] = {
+constexpr int bishopTableBlack[64] = {
     20, 10, 10, 10, 10, 10, 10, 20,
     10, 0, 0, 0, 0, 0, 0, 10,
     10, 0, -5, -10, -10, -5, 0, 10,
@@ -58,7 +60,7 @@ const int bishopTableBlack[64] = {
     20, 10, 10, 10, 10, 10, 10, 20
 };
 
-const int bishopTableWhite[64] = {
+constexpr int bishopTableWhite[64] = {
     -20, -10, -10, -10, -10, -10, -10, -20,
     -10, 5, 0, 0, 0, 0, 5, -10,
     -10, 10, 10, 10, 10, 10, 10, -10,
@@ -69,7 +71,7 @@ const int bishopTableWhite[64] = {
     -20, -10, -10, -10, -10, -10, -10, -20
 };
 
-const int rookTableWhite[64] = {
+constexpr int rookTableWhite[64] = {
     0, 0, 0, 0, 0, 0, 0, 0,
     5, 10, 10, 10, 10, 10, 10, 5,
     -5, 0, 0, 0, 0, 0, 0, -5,
@@ -80,7 +82,7 @@ const int rookTableWhite[64] = {
     0, 0, 0, 5, 5, 0, 0, 0
 };
 
-const int rookTableBlack[64] = {
+constexpr int rookTableBlack[64] = {
     0, 0, 0, -5, -5, 0, 0, 0,
     5, 0, 0, 0, 0, 0, 0, 5,
     5, 0, 0, 0, 0, 0, 0, 5,
@@ -91,7 +93,7 @@ const int rookTableBlack[64] = {
     0, 0, 0, 0, 0, 0, 0, 0
 };
 
-const int queenTableBlack[64] = {
+constexpr int queenTableBlack[64] = {
     20, 10, 10, 5, 5, 10, 10, 20,
     10, 0, 0, 0, 0, 0, 0, 10,
     10, 0, -5, -5, -5, -5, 0, 10,
@@ -102,7 +104,7 @@ const int queenTableBlack[64] = {
     20, 10, 10, 5, 5, 10, 10, 20
 };
 
-const int queenTableWhite[64] = {
+constexpr int queenTableWhite[64] = {
     -20, -10, -10, -5, -5, -10, -10, -20,
     -10, 0, 5, 0, 0, 0, 0, -10,
     -10, 5, 5, 5, 5, 5, 0, -10,
@@ -113,7 +115,7 @@ const int queenTableWhite[64] = {
     -20, -10, -10, -5, -5, -10, -10, -20
 };
 
-const int kingTableBlack[64] = {
+constexpr int kingTableBlack[64] = {
     30, 40, 40, 50, 50, 40, 40, 30,
     30, 40, 40, 50, 50, 40, 40, 30,
     30, 40, 40, 50, 50, 40, 40, 30,
@@ -124,7 +126,7 @@ const int kingTableBlack[64] = {
     -20, -30, -10, 0, 0, -10, -30, -20
 };
 
-const int kingTableWhite[64] = {
+constexpr int kingTableWhite[64] = {
     20, 30, 10, 0, 0, 10, 30, 20,
     20, 20, 0, 0, 0, 0, 20, 20,
     -10, -20, -20, -20, -20, -20, -20, -10,
@@ -135,4 +137,51 @@ const int kingTableWhite[64] = {
     -30, -40, -40, -50, -50, -40, -40, -30
 };
 
-const int emptyTable[64] = { 0 };
+// Endgame tables, the middlegame ones above are used for the other pieces
+// Pawns are worth more the closer they get to promoting and the king should come to the centre
+
+constexpr int pawnEndTableBlack[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    -80, -80, -80, -80, -80, -80, -80, -80,
+    -50, -50, -50, -50, -50, -50, -50, -50,
+    -30, -30, -30, -30, -30, -30, -30, -30,
+    -15, -15, -15, -15, -15, -15, -15, -15,
+    -5, -5, -5, -5, -5, -5, -5, -5,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+constexpr int pawnEndTableWhite[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    5, 5, 5, 5, 5, 5, 5, 5,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    30, 30, 30, 30, 30, 30, 30, 30,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    80, 80, 80, 80, 80, 80, 80, 80,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+constexpr int kingEndTableBlack[64] = {
+    50, 40, 30, 20, 20, 30, 40, 50,
+    30, 20, 10, 0, 0, 10, 20, 30,
+    30, 10, -20, -30, -30, -20, 10, 30,
+    30, 10, -30, -40, -40, -30, 10, 30,
+    30, 10, -30, -40, -40, -30, 10, 30,
+    30, 10, -20, -30, -30, -20, 10, 30,
+    30, 30, 0, 0, 0, 0, 30, 30,
+    50, 30, 30, 30, 30, 30, 30, 50
+};
+
+constexpr int kingEndTableWhite[64] = {
+    -50, -30, -30, -30, -30, -30, -30, -50,
+    -30, -30, 0, 0, 0, 0, -30, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -20, -10, 0, 0, -10, -20, -30,
+    -50, -40, -30, -20, -20, -30, -40, -50
+};
+
+constexpr int emptyTable[64] = { 0 };
@@ -0,0 +1,394 @@
+#include "Position.h"
+#include "BitboardEvaluator.h"
+#include "Evaluation.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+// makeMove ANDs the rights with the entries for both squares, so moving a king or rook,
+// or capturing a rook, takes away the rights that piece was part of
+static const uint8_t castlingMask[64] = {
+    ALL_CASTLING & ~WHITE_QUEENSIDE, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE), ALL_CASTLING, ALL_CASTLING, ALL_CASTLING & ~WHITE_KINGSIDE,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~BLACK_QUEENSIDE, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE), ALL_CASTLING, ALL_CASTLING, ALL_CASTLING & ~BLACK_KINGSIDE,
+};
+
+// Only remember an en passant square when a pawn of the side to move (Us) stands next to
+// the pawn that moved two, otherwise the same position would hash differently for nothing
+// Those are exactly the squares a pawn of the other side on the en passant square attacks
+template <Color Us>
+static bool enPassantPossible(const Position& position, int epSquare)
+{
+    return (Side<Side<Us>::Them>::pawnAttacks(1ULL << epSquare) & position.pieces(Side<Us>::PAWNS)) != 0;
+}
+
+// The running scores follow every piece put on or taken off the board
+static inline void addPieceScore(Position& position, int piece, int square)
+{
+    position.middlegame += evalTables.middlegame[piece][square];
+    position.endgame += evalTables.endgame[piece][square];
+}
+
+static inline void removePieceScore(Position& position, int piece, int square)
+{
+    position.middlegame -= evalTables.middlegame[piece][square];
+    position.endgame -= evalTables.endgame[piece][square];
+}
+
+Position::Position()
+{
+    for (int i = 0; i < e_numBitboards; i++) {
+        bitboards[i] = 0;
+    }
+    for (int i = 0; i < 64; i++) {
+        board[i] = EMPTY_SQUARES;
+    }
+    bitboards[EMPTY_SQUARES] = ~0ULL;
+    sideToMove = WHITE;
+    castling = 0;
+    epSquare = NO_SQUARE;
+    halfmoveClock = 0;
+    hash = computeHash();
+    computeScores();
+}
+
+void Position::setFromState(const std::string& state, int side)
+{
+    int lookup[128];
+    for (int i = 0; i < 128; i++) { lookup[i] = EMPTY_SQUARES; }
+
+    lookup['P'] = WHITE_PAWNS;
+    lookup['N'] = WHITE_KNIGHTS;
+    lookup['B'] = WHITE_BISHOPS;
+    lookup['R'] = WHITE_ROOKS;
+    lookup['Q'] = WHITE_QUEENS;
+    lookup['K'] = WHITE_KING;
+    lookup['p'] = BLACK_PAWNS;
+    lookup['n'] = BLACK_KNIGHTS;
+    lookup['b'] = BLACK_BISHOPS;
+    lookup['r'] = BLACK_ROOKS;
+    lookup['q'] = BLACK_QUEENS;
+    lookup['k'] = BLACK_KING;
+
+    for (int i = 0; i < e_numBitboards; i++) {
+        bitboards[i] = 0;
+    }
+
+    for (int i = 0; i < 64; i++) {
+        int piece = lookup[state[i] & 127];
+        board[i] = piece;
+        bitboards[piece] |= 1ULL << i;
+    }
+
+    bitboards[WHITE_ALL_PIECES] = bitboards[WHITE_PAWNS] |
+        bitboards[WHITE_KNIGHTS] |
+        bitboards[WHITE_BISHOPS] |
+        bitboards[WHITE_ROOKS] |
+        bitboards[WHITE_QUEENS] |
+        bitboards[WHITE_KING];
+
+    bitboards[BLACK_ALL_PIECES] = bitboards[BLACK_PAWNS] |
+        bitboards[BLACK_KNIGHTS] |
+        bitboards[BLACK_BISHOPS] |
+        bitboards[BLACK_ROOKS] |
+        bitboards[BLACK_QUEENS] |
+        bitboards[BLACK_KING];
+
+    bitboards[OCCUPANCY] = bitboards[WHITE_ALL_PIECES] | bitboards[BLACK_ALL_PIECES];
+    bitboards[EMPTY_SQUARES] = ~bitboards[OCCUPANCY];
+
+    sideToMove = side;
+    castling = 0;
+    epSquare = NO_SQUARE;
+    halfmoveClock = 0;
+    hash = computeHash();
+    computeScores();
+}
+
+bool Position::setFromFEN(const std::string& fen)
+{
+    std::string state(64, '0');
+    int row = 7;
+    int col = 0;
+    size_t i = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char ch = fen[i];
+        if (isdigit(ch)) {
+            col += ch - '0'; // If you see a number, move over that number of columns
+        }
+        else if (ch == '/') {
+            row--; // Go down a row when you see a forward slash
+            col = 0;
+        }
+        else {
+            if (row < 0 || col > 7) return false;
+            state[row * 8 + col] = ch;
+            col++;
+        }
+    }
+
+    // The rest of the fields are optional, anything missing is treated as "-"
+    std::string fields[4];
+    for (auto& field : fields) {
+        while (i < fen.size() && fen[i] == ' ') i++;
+        while (i < fen.size() && fen[i] != ' ') field += fen[i++];
+    }
+
+    setFromState(state, fields[0] == "b" ? BLACK : WHITE);
+
+    for (char ch : fields[1]) {
+        switch (ch) {
+            case 'K': castling |= WHITE_KINGSIDE; break;
+            case 'Q': castling |= WHITE_QUEENSIDE; break;
+            case 'k': castling |= BLACK_KINGSIDE; break;
+            case 'q': castling |= BLACK_QUEENSIDE; break;
+            default: break;
+        }
+    }
+
+    if (fields[2].size() == 2 && fields[2][0] >= 'a' && fields[2][0] <= 'h' && (fields[2][1] == '3' || fields[2][1] == '6')) {
+        const int square = (fields[2][1] - '1') * 8 + (fields[2][0] - 'a');
+        if (sideToMove == WHITE ? enPassantPossible<WHITE>(*this, square) : enPassantPossible<BLACK>(*this, square)) {
+            epSquare = square;
+        }
+    }
+
+    // "-" or anything else that isn't a number reads as 0
+    halfmoveClock = std::clamp(std::atoi(fields[3].c_str()), 0, 1000);
+
+    hash = computeHash();
+    return true;
+}
+
+// Full recalculation, only used when setting up a position
+uint64_t Position::computeHash() const
+{
+    uint64_t key = 0;
+    for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+        bitboards[piece].forEachBit([&](int square) {
+            key ^= Zobrist.pieces[piece][square];
+        });
+    }
+    if (sideToMove == BLACK) {
+        key ^= Zobrist.side;
+    }
+    key ^= Zobrist.castling[castling];
+    if (epSquare != NO_SQUARE) {
+        key ^= Zobrist.enPassant[epSquare & 7];
+    }
+    return key;
+}
+
+// Full recalculation, only used when setting up a position
+void Position::computeScores()
+{
+    const EvalScores scores = evaluateBitboards(bitboards);
+    middlegame = scores.middlegame;
+    endgame = scores.endgame;
+    phase = scores.phase;
+}
+
+template <Color Us>
+void Position::makeMove(const BitMove& move, UndoInfo& undo)
+{
+    using Our = Side<Us>;
+    using Their = Side<Our::Them>;
+
+    const int from = move.from();
+    const int to = move.to();
+    const uint64_t fromBit = 1ULL << from;
+    const uint64_t toBit = 1ULL << to;
+    const int moving = board[from];
+    int captured = board[to];
+    int capturedSquare = to;
+
+    undo.castling = castling;
+    undo.epSquare = epSquare;
+    undo.hash = hash;
+    undo.middlegame = middlegame;
+    undo.endgame = endgame;
+    undo.phase = phase;
+    undo.halfmoveClock = halfmoveClock;
+
+    // A pawn moving onto the en passant square takes the pawn beside it
+    if (move.isEnPassant()) {
+        capturedSquare = to - Our::Up;
+        captured = Their::PAWNS;
+    }
+    undo.captured = captured;
+    halfmoveClock = captured != EMPTY_SQUARES || moving == Our::PAWNS ? 0 : halfmoveClock + 1;
+
+    // Remove whatever was captured from the other side's boards
+    if (captured != EMPTY_SQUARES) {
+        const uint64_t capturedBit = 1ULL << capturedSquare;
+        bitboards[captured] ^= capturedBit;
+        bitboards[Their::ALL_PIECES] ^= capturedBit;
+        board[capturedSquare] = EMPTY_SQUARES;
+        hash ^= Zobrist.pieces[captured][capturedSquare];
+        removePieceScore(*this, captured, capturedSquare);
+        phase -= phaseWeights[captured];
+    }
+
+    // Move the piece on its own board and its side's board, a promotion lands as the new piece
+    const int placed = move.isPromotion() ? (move.promotion() - 1) * 2 + Us : moving;
+    bitboards[moving] ^= fromBit;
+    bitboards[placed] ^= toBit;
+    bitboards[Our::ALL_PIECES] ^= fromBit | toBit;
+    board[from] = EMPTY_SQUARES;
+    board[to] = placed;
+    hash ^= Zobrist.pieces[moving][from] ^ Zobrist.pieces[placed][to];
+    removePieceScore(*this, moving, from);
+    addPieceScore(*this, placed, to);
+    phase += phaseWeights[placed] - phaseWeights[moving];
+
+    // Castling is a king move of two squares, the rook jumps to the square the king passed
+    if (move.isCastle()) {
+        const int rookFrom = move.flags() == KING_CASTLE ? from + 3 : from - 4;
+        const int rookTo = (from + to) / 2;
+        bitboards[Our::ROOKS] ^= (1ULL << rookFrom) | (1ULL << rookTo);
+        bitboards[Our::ALL_PIECES] ^= (1ULL << rookFrom) | (1ULL << rookTo);
+        board[rookFrom] = EMPTY_SQUARES;
+        board[rookTo] = Our::ROOKS;
+        hash ^= Zobrist.pieces[Our::ROOKS][rookFrom] ^ Zobrist.pieces[Our::ROOKS][rookTo];
+        removePieceScore(*this, Our::ROOKS, rookFrom);
+        addPieceScore(*this, Our::ROOKS, rookTo);
+    }
+
+    bitboards[OCCUPANCY] = bitboards[WHITE_ALL_PIECES] | bitboards[BLACK_ALL_PIECES];
+    bitboards[EMPTY_SQUARES] = ~bitboards[OCCUPANCY];
+
+    hash ^= Zobrist.castling[castling];
+    castling &= castlingMask[from] & castlingMask[to];
+    hash ^= Zobrist.castling[castling];
+
+    if (epSquare != NO_SQUARE) {
+        hash ^= Zobrist.enPassant[epSquare & 7];
+        epSquare = NO_SQUARE;
+    }
+
+    hash ^= Zobrist.side;
+    sideToMove = Our::Them;
+
+    if (move.isDoublePawnPush()) {
+        const int square = from + Our::Up;
+        if (enPassantPossible<Our::Them>(*this, square)) {
+            epSquare = square;
+            hash ^= Zobrist.enPassant[square & 7];
+        }
+    }
+}
+
+template <Color Us>
+void Position::unmakeMove(const BitMove& move, const UndoInfo& undo)
+{
+    using Our = Side<Us>;
+    using Their = Side<Our::Them>;
+
+    const int from = move.from();
+    const int to = move.to();
+    const uint64_t fromBit = 1ULL << from;
+    const uint64_t toBit = 1ULL << to;
+    const int placed = board[to];
+    const int moving = move.isPromotion() ? Our::PAWNS : placed;
+    const int captured = undo.captured;
+
+    bitboards[placed] ^= toBit;
+    bitboards[moving] ^= fromBit;
+    bitboards[Our::ALL_PIECES] ^= fromBit | toBit;
+    board[to] = EMPTY_SQUARES;
+    board[from] = moving;
+
+    if (captured != EMPTY_SQUARES) {
+        const int capturedSquare = move.isEnPassant() ? to - Our::Up : to;
+        const uint64_t capturedBit = 1ULL << capturedSquare;
+        bitboards[captured] ^= capturedBit;
+        bitboards[Their::ALL_PIECES] ^= capturedBit;
+        board[capturedSquare] = captured;
+    }
+
+    if (move.isCastle()) {
+        const int rookFrom = move.flags() == KING_CASTLE ? from + 3 : from - 4;
+        const int rookTo = (from + to) / 2;
+        bitboards[Our::ROOKS] ^= (1ULL << rookFrom) | (1ULL << rookTo);
+        bitboards[Our::ALL_PIECES] ^= (1ULL << rookFrom) | (1ULL << rookTo);
+        board[rookTo] = EMPTY_SQUARES;
+        board[rookFrom] = Our::ROOKS;
+    }
+
+    bitboards[OCCUPANCY] = bitboards[WHITE_ALL_PIECES] | bitboards[BLACK_ALL_PIECES];
+    bitboards[EMPTY_SQUARES] = ~bitboards[OCCUPANCY];
+
+    castling = undo.castling;
+    epSquare = undo.epSquare;
+    hash = undo.hash;
+    middlegame = undo.middlegame;
+    endgame = undo.endgame;
+    phase = undo.phase;
+    halfmoveClock = undo.halfmoveClock;
+    sideToMove = Us;
+}
+
+template void Position::makeMove<WHITE>(const BitMove& move, UndoInfo& undo);
+template void Position::makeMove<BLACK>(const BitMove& move, UndoInfo& undo);
+template void Position::unmakeMove<WHITE>(const BitMove& move, const UndoInfo& undo);
+template void Position::unmakeMove<BLACK>(const BitMove& move, const UndoInfo& undo);
+
+void Position::makeNullMove(UndoInfo& undo)
+{
+    undo.epSquare = epSquare;
+    undo.hash = hash;
+    undo.halfmoveClock = halfmoveClock;
+    halfmoveClock = 0;
+
+    if (epSquare != NO_SQUARE) {
+        hash ^= Zobrist.enPassant[epSquare & 7];
+        epSquare = NO_SQUARE;
+    }
+    hash ^= Zobrist.side;
+    sideToMove ^= 1;
+}
+
+void Position::unmakeNullMove(const UndoInfo& undo)
+{
+    epSquare = undo.epSquare;
+    hash = undo.hash;
+    halfmoveClock = undo.halfmoveClock;
+    sideToMove ^= 1;
+}
+
+bool isRepetition(const Position& position, const uint64_t* keys, int count, int searchPlies)
+{
+    const int limit = std::min(position.halfmoveClock, count);
+    int seen = 0;
+    for (int back = 4; back <= limit; back += 2) {
+        if (keys[count - back] == position.hash && (back <= searchPlies || ++seen == 2)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string squareToString(int square)
+{
+    std::string name;
+    name += static_cast<char>('a' + (square & 7));
+    name += static_cast<char>('1' + (square >> 3));
+    return name;
+}
+
+std::string moveToString(const BitMove& move)
+{
+    std::string name = squareToString(move.from()) + squareToString(move.to());
+    if (move.isPromotion()) {
+        name += " pnbrqk"[move.promotion()];
+    }
+    return name;
+}
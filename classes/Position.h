@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <string>
+
+// Player colors, plain ints wherever the side is only known at run time
+enum Color
+{
+    WHITE,
+    BLACK
+};
+
+// White and black boards are interleaved so that (piece & 1) is the color of a piece
+// and WHITE_X + color selects the board for either side
+enum BitboardIndex
+{
+    WHITE_PAWNS,
+    BLACK_PAWNS,
+    WHITE_KNIGHTS,
+    BLACK_KNIGHTS,
+    WHITE_BISHOPS,
+    BLACK_BISHOPS,
+    WHITE_ROOKS,
+    BLACK_ROOKS,
+    WHITE_QUEENS,
+    BLACK_QUEENS,
+    WHITE_KING,
+    BLACK_KING,
+    WHITE_ALL_PIECES,
+    BLACK_ALL_PIECES,
+    OCCUPANCY,
+    EMPTY_SQUARES,
+    e_numBitboards
+};
+
+// Castling rights, one bit each so they fit in a byte
+enum CastlingRights
+{
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8,
+    ALL_CASTLING = 15
+};
+
+constexpr int NO_SQUARE = 64;
+
+// Everything about a side that move generation and make/unmake need, as compile time
+// constants, so code templated on the side to move has no color checks left in it
+template <Color Us>
+struct Side {
+    static constexpr Color Them = Us == WHITE ? BLACK : WHITE;
+    static constexpr int Up = Us == WHITE ? 8 : -8;   // square offset of a pawn push
+    static constexpr uint64_t PushRank = Us == WHITE ? 0x0000000000FF0000ULL : 0x0000FF0000000000ULL; // a pawn pushed once can push again from here
+    static constexpr uint64_t PromotionRank = Us == WHITE ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+    static constexpr int KingHome = Us == WHITE ? 4 : 60;
+    static constexpr uint8_t Kingside = Us == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+    static constexpr uint8_t Queenside = Us == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+
+    // This side's boards, see BitboardIndex
+    static constexpr int PAWNS = WHITE_PAWNS + int(Us);
+    static constexpr int KNIGHTS = WHITE_KNIGHTS + int(Us);
+    static constexpr int BISHOPS = WHITE_BISHOPS + int(Us);
+    static constexpr int ROOKS = WHITE_ROOKS + int(Us);
+    static constexpr int QUEENS = WHITE_QUEENS + int(Us);
+    static constexpr int KING = WHITE_KING + int(Us);
+    static constexpr int ALL_PIECES = WHITE_ALL_PIECES + int(Us);
+
+    static constexpr uint64_t forward(uint64_t bits) { return Us == WHITE ? bits << 8 : bits >> 8; }
+    // Pawn captures towards the a file and towards the h file
+    static constexpr int CaptureWest = Up - 1;
+    static constexpr int CaptureEast = Up + 1;
+    static constexpr uint64_t attacksWest(uint64_t pawns) {
+        pawns &= 0xFEFEFEFEFEFEFEFEULL;
+        return Us == WHITE ? pawns << 7 : pawns >> 9;
+    }
+    static constexpr uint64_t attacksEast(uint64_t pawns) {
+        pawns &= 0x7F7F7F7F7F7F7F7FULL;
+        return Us == WHITE ? pawns << 9 : pawns >> 7;
+    }
+    static constexpr uint64_t pawnAttacks(uint64_t pawns) { return attacksWest(pawns) | attacksEast(pawns); }
+};
+
+// Everything needed to take a move back that the move itself does not store
+struct UndoInfo {
+    uint8_t captured;
+    uint8_t castling;
+    uint8_t epSquare;
+    uint64_t hash;
+    int middlegame;
+    int endgame;
+    int phase;
+    int halfmoveClock;
+};
+
+//
+// Board representation used by the AI search
+// Holds the piece bitboards plus a square to piece lookup so that a move can be made
+// or taken back by touching only the boards involved instead of rebuilding everything
+//
+struct Position {
+    BitboardElement bitboards[e_numBitboards];
+    uint8_t board[64]; // BitboardIndex of the piece on each square, EMPTY_SQUARES if none
+    int sideToMove;    // WHITE or BLACK
+    uint8_t castling;  // CastlingRights still available
+    uint8_t epSquare;  // square behind a pawn that just moved two, NO_SQUARE unless it can be taken en passant
+    uint64_t hash;     // Zobrist key, kept up to date by makeMove/unmakeMove
+    int halfmoveClock; // plies since the last capture or pawn move, for the fifty move rule
+
+    // Material plus piece square scores (see Evaluation.h) and game phase, also kept up to
+    // date by makeMove/unmakeMove so evaluating a leaf doesn't need to look at the board
+    int middlegame;
+    int endgame;
+    int phase;
+
+    Position();
+
+    // Build the position from a 64 character state string (see Chess::stateString)
+    // The state has no castling or en passant information, so neither is available
+    void setFromState(const std::string& state, int side = WHITE);
+    // Build the position from a FEN string, the placement, active color, castling,
+    // en passant and halfmove clock fields are used
+    bool setFromFEN(const std::string& fen);
+    uint64_t computeHash() const;
+    // Full recalculation of middlegame, endgame and phase
+    void computeScores();
+
+    // Handles captures, en passant, castling and promotion, the move must be legal
+    // Us is the side making the move, the search knows it at compile time and the plain
+    // versions look at sideToMove
+    template <Color Us> void makeMove(const BitMove& move, UndoInfo& undo);
+    template <Color Us> void unmakeMove(const BitMove& move, const UndoInfo& undo);
+    void makeMove(const BitMove& move, UndoInfo& undo) {
+        sideToMove == WHITE ? makeMove<WHITE>(move, undo) : makeMove<BLACK>(move, undo);
+    }
+    void unmakeMove(const BitMove& move, const UndoInfo& undo) {
+        sideToMove == WHITE ? unmakeMove<BLACK>(move, undo) : unmakeMove<WHITE>(move, undo);
+    }
+    // Pass the turn without moving, for null move pruning, the position mustn't be in check
+    // The halfmove clock starts again so a repetition check never looks back past it
+    void makeNullMove(UndoInfo& undo);
+    void unmakeNullMove(const UndoInfo& undo);
+
+    uint64_t pieces(int index) const { return bitboards[index].getData(); }
+    int pieceAt(int square) const { return board[square]; }
+
+    // BitboardIndex of the piece a move of the side to move moves and of the piece it
+    // takes, EMPTY_SQUARES when it takes nothing
+    int movedPiece(const BitMove& move) const { return board[move.from()]; }
+    int capturedPiece(const BitMove& move) const {
+        return move.isEnPassant() ? WHITE_PAWNS + (sideToMove ^ 1) : board[move.to()];
+    }
+};
+
+// Whether the position is a repetition: seen once before within the last searchPlies plies
+// (the search's own path), or twice before anywhere. keys are the Zobrist keys of the
+// positions leading up to it, most recent last. Only positions since the last capture or
+// pawn move can be the same, and only every other one has the same side to move.
+bool isRepetition(const Position& position, const uint64_t* keys, int count, int searchPlies = 0);
+
+// Coordinate notation used by UCI and perft divide, "e2e4"
+std::string squareToString(int square);
+std::string moveToString(const BitMove& move);
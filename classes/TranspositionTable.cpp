@@ -0,0 +1,114 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+    : _mask(0)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    // Round down to a power of two so a bucket index is just key & mask
+    size_t count = 1;
+    const size_t maxCount = (megabytes * 1024 * 1024) / sizeof(Bucket);
+    while (count * 2 <= maxCount) {
+        count *= 2;
+    }
+
+    _buckets.reset(new Bucket[count]);
+    _mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i <= _mask; i++) {
+        for (auto& entry : _buckets[i].entries) {
+            entry.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Data layout: move in bits 0-15, score in bits 16-33, depth in bits 34-40, bound in bits 41-42,
+// the search that stored it in bits 43-45, the top 18 bits of the key in bits 46-63
+// A stored bound is never TT_NONE, so 0 is an empty entry
+constexpr uint64_t KEY_MASK = 0xFFFFC00000000000ULL;
+
+uint64_t TranspositionTable::pack(uint64_t key, int depth, int score, TTBound bound, const BitMove& move, int generation)
+{
+    uint64_t data = move.data;
+    data |= static_cast<uint64_t>(score & 0x3FFFF) << 16;
+    data |= static_cast<uint64_t>(depth & 127) << 34;
+    data |= static_cast<uint64_t>(bound & 3) << 41;
+    data |= static_cast<uint64_t>(generation & GENERATION_MASK) << 43;
+    data |= key & KEY_MASK;
+    return data;
+}
+
+TTData TranspositionTable::unpack(uint64_t data)
+{
+    TTData result;
+    result.move.data = static_cast<uint16_t>(data);
+    // Shift the 18 bit score to the top and back down again to sign extend it
+    result.score = static_cast<int32_t>(static_cast<uint32_t>(data >> 16) << 14) >> 14;
+    result.depth = (data >> 34) & 127;
+    result.bound = static_cast<TTBound>((data >> 41) & 3);
+    return result;
+}
+
+bool TranspositionTable::sameKey(uint64_t data, uint64_t key)
+{
+    return data != 0 && ((data ^ key) & KEY_MASK) == 0;
+}
+
+// Depth, less a few plies for each search since the entry was stored, an empty entry is
+// the first to go
+int TranspositionTable::replaceValue(uint64_t data) const
+{
+    if (data == 0) return -1000;
+    const int age = (_generation - static_cast<int>((data >> 43) & GENERATION_MASK)) & GENERATION_MASK;
+    return unpack(data).depth - 8 * age;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& data) const
+{
+    const Bucket& bucket = _buckets[key & _mask];
+    for (const auto& entry : bucket.entries) {
+        const uint64_t stored = entry.load(std::memory_order_relaxed);
+        if (sameKey(stored, key)) {
+            data = unpack(stored);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, TTBound bound, const BitMove& move)
+{
+    Bucket& bucket = _buckets[key & _mask];
+
+    // The entry for the same position if there is one, otherwise the least useful
+    std::atomic<uint64_t>* replace = &bucket.entries[0];
+    int replaceWorth = 1 << 30;
+    for (auto& entry : bucket.entries) {
+        const uint64_t stored = entry.load(std::memory_order_relaxed);
+        if (sameKey(stored, key)) {
+            // Keep a deeper result for the same position unless the new one is exact, but
+            // mark it as this search's since it is still being used
+            if (bound != TT_EXACT && unpack(stored).depth > depth) {
+                const uint64_t generationBits = static_cast<uint64_t>(GENERATION_MASK) << 43;
+                entry.store((stored & ~generationBits) | (static_cast<uint64_t>(_generation) << 43), std::memory_order_relaxed);
+                return;
+            }
+            replace = &entry;
+            break;
+        }
+        const int worth = replaceValue(stored);
+        if (worth < replaceWorth) {
+            replace = &entry;
+            replaceWorth = worth;
+        }
+    }
+
+    replace->store(pack(key, depth, score, bound, move, _generation), std::memory_order_relaxed);
+}
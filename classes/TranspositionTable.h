@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+enum TTBound : uint8_t
+{
+    TT_NONE,
+    TT_EXACT,
+    TT_LOWER, // score is at least this (failed high)
+    TT_UPPER  // score is at most this (failed low)
+};
+
+struct TTData {
+    int score;
+    int depth;
+    TTBound bound;
+    BitMove move;
+};
+
+//
+// Fixed size hash table of search results shared by every search thread
+// Each entry is a single 64 bit word holding the result and the top bits of its key, so
+// a read racing a write on another thread sees either the old entry or the new one and
+// nothing needs a lock. The low bits of the key pick a bucket of four entries that share
+// half a cache line, a probe looks at all four and a store replaces the least useful.
+// The table is kept from one search to the next, each entry remembers which search wrote
+// it, and an entry left over from earlier searches is worth less the older it is
+//
+class TranspositionTable
+{
+public:
+    TranspositionTable(size_t megabytes = 16);
+
+    // Not safe to call while a search is using the table
+    void resize(size_t megabytes);
+    void clear();
+    // Called at the start of each search, entries stored from then on are the newest
+    void newSearch() { _generation = (_generation + 1) & GENERATION_MASK; }
+
+    bool probe(uint64_t key, TTData& data) const;
+    void store(uint64_t key, int depth, int score, TTBound bound, const BitMove& move);
+
+    size_t entryCount() const { return (_mask + 1) * BUCKET_SIZE; }
+
+private:
+    static constexpr int BUCKET_SIZE = 4;
+    static constexpr int GENERATION_MASK = 7;  // searches are counted in 3 bits and wrap round
+
+    struct alignas(32) Bucket {
+        std::atomic<uint64_t> entries[BUCKET_SIZE];
+    };
+
+    static uint64_t pack(uint64_t key, int depth, int score, TTBound bound, const BitMove& move, int generation);
+    static TTData unpack(uint64_t data);
+    static bool sameKey(uint64_t data, uint64_t key);
+    int replaceValue(uint64_t data) const;
+
+    std::unique_ptr<Bucket[]> _buckets;
+    size_t _mask;
+    int _generation = 0;
+};
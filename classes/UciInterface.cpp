@@ -0,0 +1,267 @@
+#include "UciInterface.h"
+#include <algorithm>
+#include <cstdlib>
+
+static const char* startPositionFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Centipawns, or moves to mate, negative when the engine is the one being mated
+static std::string scoreToString(int score)
+{
+    if (score >= MATE_IN_MAX_PLY) return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+    if (score <= -MATE_IN_MAX_PLY) return "mate " + std::to_string(-(MATE_SCORE + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+UciInterface::UciInterface(std::istream& input, std::ostream& output)
+    : _input(input), _output(output), _cancel(false)
+{
+    _position.setFromFEN(startPositionFEN);
+}
+
+UciInterface::~UciInterface()
+{
+    stopSearch();
+}
+
+void UciInterface::loop()
+{
+    std::string line;
+    while (std::getline(_input, line)) {
+        if (!command(line)) {
+            stopSearch();
+            return;
+        }
+    }
+
+    // Piped input ends straight after "go", let a bounded search finish and report its move
+    if (_infinite) {
+        stopSearch();
+    }
+    else {
+        waitForSearch();
+    }
+}
+
+bool UciInterface::command(const std::string& line)
+{
+    std::istringstream args(line);
+    std::string token;
+    args >> token;
+
+    if (token == "uci") {
+        send("id name imgui-chess");
+        send("id author imgui-chess");
+        send("option name Hash type spin default 16 min 1 max 4096");
+        send("option name Threads type spin default 1 min 1 max 256");
+        send("option name NullMove type check default true");
+        send("option name LMR type check default true");
+        send("option name Futility type check default true");
+        send("uciok");
+    }
+    else if (token == "isready") {
+        send("readyok");
+    }
+    else if (token == "setoption") {
+        setOption(args);
+    }
+    else if (token == "ucinewgame") {
+        stopSearch();
+        _position.setFromFEN(startPositionFEN);
+        _history.clear();
+        _engine.newGame();
+    }
+    else if (token == "position") {
+        position(args);
+    }
+    else if (token == "go") {
+        go(args);
+    }
+    else if (token == "stop") {
+        stopSearch();
+    }
+    else if (token == "quit") {
+        return false;
+    }
+    // Anything else is ignored, as the protocol asks
+    return true;
+}
+
+// position [startpos | fen <fen>] [moves <move> ...]
+void UciInterface::position(std::istringstream& args)
+{
+    stopSearch();
+
+    std::string token;
+    args >> token;
+    if (token == "startpos") {
+        _position.setFromFEN(startPositionFEN);
+        args >> token;
+    }
+    else if (token == "fen") {
+        std::string fen;
+        while (args >> token && token != "moves") {
+            fen += token + " ";
+        }
+        if (!_position.setFromFEN(fen)) {
+            _position.setFromFEN(startPositionFEN);
+        }
+    }
+    else {
+        return;
+    }
+    _history.clear();
+
+    if (token != "moves") return;
+
+    // Match each move against the legal moves, so castling, en passant and promotion
+    // come out of the generator the same way they do in the search
+    while (args >> token) {
+        MoveList moves;
+        _engine.generateAllMoves(_position, _position.sideToMove, moves);
+
+        auto it = std::find_if(moves.begin(), moves.end(), [&](const BitMove& move) {
+            return moveToString(move) == token;
+        });
+        if (it == moves.end()) {
+            send("info string illegal move " + token);
+            return;
+        }
+
+        _history.push_back(_position.hash);
+        UndoInfo undo;
+        _position.makeMove(*it, undo);
+    }
+}
+
+// go [depth <plies>] [movetime <ms>] [nodes <count>] [wtime/btime/winc/binc/movestogo <n>] [infinite]
+void UciInterface::go(std::istringstream& args)
+{
+    stopSearch();
+
+    SearchLimits limits;
+    long long clock[2] = { 0, 0 };
+    long long increment[2] = { 0, 0 };
+    long long movesToGo = 0;
+    _infinite = false;
+
+    std::string token;
+    while (args >> token) {
+        if (token == "depth") args >> limits.maxDepth;
+        else if (token == "movetime") args >> limits.timeLimit;
+        else if (token == "nodes") args >> limits.nodeLimit;
+        else if (token == "wtime") args >> clock[WHITE];
+        else if (token == "btime") args >> clock[BLACK];
+        else if (token == "winc") args >> increment[WHITE];
+        else if (token == "binc") args >> increment[BLACK];
+        else if (token == "movestogo") args >> movesToGo;
+        else if (token == "infinite") _infinite = true;
+    }
+    limits.maxDepth = std::clamp(limits.maxDepth, 1, MAX_DEPTH);
+
+    // Playing on a clock, spend an even share of what is left plus most of the increment
+    const int side = _position.sideToMove;
+    if (limits.timeLimit == 0 && clock[side] > 0) {
+        const long long share = clock[side] / (movesToGo > 0 ? movesToGo : 30) + increment[side] * 3 / 4;
+        limits.timeLimit = static_cast<int>(std::max(1LL, std::min(share, clock[side] / 2)));
+    }
+    if (_infinite) {
+        limits.maxDepth = MAX_DEPTH;
+        limits.timeLimit = 0;
+        limits.nodeLimit = 0;
+    }
+
+    _cancel = false;
+    limits.cancel = &_cancel;
+    limits.onIteration = [this](const SearchResult& result) { send(infoLine(result)); };
+
+    const Position position = _position;
+    const bool infinite = _infinite;
+    _searchThread = std::thread([this, position, history = _history, limits, infinite]() {
+        SearchResult result = _engine.search(position, limits, history);
+
+        // Every finished iteration has been reported already
+        if (result.depth == 0) {
+            send(infoLine(result));
+        }
+
+        // An infinite search can finish early, on a mate or at the depth limit, but the
+        // move must not be sent until the GUI says stop
+        if (infinite) {
+            std::unique_lock<std::mutex> lock(_stopMutex);
+            _stopped.wait(lock, [this]() { return _cancel.load(); });
+        }
+        send("bestmove " + (result.bestMove.isNone() ? std::string("0000") : moveToString(result.bestMove)));
+    });
+}
+
+std::string UciInterface::infoLine(const SearchResult& result)
+{
+    const long long nps = result.seconds > 0.0 ? static_cast<long long>(result.nodes / result.seconds) : 0;
+    std::string info = "info depth " + std::to_string(result.depth) +
+        " score " + scoreToString(result.score) +
+        " nodes " + std::to_string(result.nodes) +
+        " nps " + std::to_string(nps) +
+        " time " + std::to_string(static_cast<long long>(result.seconds * 1000.0));
+    if (!result.bestMove.isNone()) {
+        info += " pv";
+        for (int i = 0; i < result.pvLength; i++) {
+            info += ' ';
+            info += moveToString(result.pv[i]);
+        }
+    }
+    return info;
+}
+
+// setoption name <Hash | Threads> value <n>
+// setoption name <NullMove | LMR | Futility> value <true | false>
+void UciInterface::setOption(std::istringstream& args)
+{
+    std::string token, name, value;
+    args >> token; // "name"
+    while (args >> token && token != "value") {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    args >> value;
+
+    // The table and thread list can't change under a running search
+    stopSearch();
+
+    if (name == "Hash") {
+        _engine.setHashSize(std::clamp(std::atoi(value.c_str()), 1, 4096));
+    }
+    else if (name == "Threads") {
+        _engine.setThreadCount(std::clamp(std::atoi(value.c_str()), 1, 256));
+    }
+    else if (name == "NullMove" || name == "LMR" || name == "Futility") {
+        SearchOptions options = _engine.searchOptions();
+        const bool enabled = value == "true";
+        if (name == "NullMove") options.nullMovePruning = enabled;
+        else if (name == "LMR") options.lateMoveReductions = enabled;
+        else options.futilityPruning = enabled;
+        _engine.setSearchOptions(options);
+    }
+}
+
+void UciInterface::stopSearch()
+{
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _cancel = true;
+    }
+    _stopped.notify_all();
+    waitForSearch();
+}
+
+void UciInterface::waitForSearch()
+{
+    if (_searchThread.joinable()) {
+        _searchThread.join();
+    }
+}
+
+// The search thread reports its move while the input thread may be answering isready
+void UciInterface::send(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(_outputMutex);
+    _output << line << std::endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ChessEngine.h"
+#include <atomic>
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// Universal Chess Interface front end for the engine, so it can be run by a chess GUI or
+// a tournament manager instead of through the imgui board
+// Commands are read from the input stream on the calling thread and searches run on
+// their own thread, so "stop" and "isready" are answered while the engine is thinking
+//
+class UciInterface
+{
+public:
+    UciInterface(std::istream& input, std::ostream& output);
+    ~UciInterface();
+
+    // Read and handle commands until "quit" or the end of the input
+    void loop();
+
+    // Handle one line, returns false for "quit"
+    bool command(const std::string& line);
+
+private:
+    void position(std::istringstream& args);
+    void go(std::istringstream& args);
+    void setOption(std::istringstream& args);
+    void stopSearch();
+    void waitForSearch();
+
+    void send(const std::string& line);
+    static std::string infoLine(const SearchResult& result);
+
+    std::istream& _input;
+    std::ostream& _output;
+    std::mutex _outputMutex;
+
+    ChessEngine _engine;
+    Position _position;
+    std::vector<uint64_t> _history; // keys of the positions the "moves" list passed through
+
+    std::thread _searchThread;
+    std::atomic<bool> _cancel;
+    std::mutex _stopMutex;            // with _stopped, wakes an infinite search waiting for "stop"
+    std::condition_variable _stopped;
+    bool _infinite = false;
+};
@@ -0,0 +1,117 @@
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int workerCount)
+{
+    if (workerCount < 1) workerCount = 1;
+
+    for (int i = 0; i < workerCount; i++) {
+        _queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (int i = 1; i < workerCount; i++) {
+        _threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _wake.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::run(int itemCount, const std::function<void(int worker, int item)>& task)
+{
+    if (itemCount <= 0) return;
+
+    // Deal the items out in order so every worker starts on the front of the list
+    const int workers = workerCount();
+    for (int item = 0; item < itemCount; item++) {
+        WorkQueue& queue = *_queues[item % workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.items.push_back(item);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _remaining = itemCount;
+        _busyWorkers = workers - 1;
+        _batch++;
+    }
+    _wake.notify_all();
+
+    drain(0);
+
+    // Wait for the helpers to finish their last items and leave the batch, so the
+    // task can't be called again after we return
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this]() { return _remaining == 0 && _busyWorkers == 0; });
+    _task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+    unsigned lastBatch = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&]() { return _quit || _batch != lastBatch; });
+            if (_quit) return;
+            lastBatch = _batch;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _busyWorkers--;
+        if (_busyWorkers == 0 && _remaining == 0) {
+            _finished.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::drain(int worker)
+{
+    int item;
+    while (takeItem(worker, item)) {
+        (*_task)(worker, item);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _remaining--;
+        if (_remaining == 0 && _busyWorkers == 0) {
+            _finished.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::takeItem(int worker, int& item)
+{
+    // Own queue first, from the front
+    {
+        WorkQueue& queue = *_queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.items.empty()) {
+            item = queue.items.front();
+            queue.items.pop_front();
+            return true;
+        }
+    }
+
+    // Then steal from the back of everyone else's
+    const int workers = workerCount();
+    for (int i = 1; i < workers; i++) {
+        WorkQueue& queue = *_queues[(worker + i) % workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.items.empty()) {
+            item = queue.items.back();
+            queue.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Small fixed size thread pool for splitting a list of work items over several threads
+// Each worker has its own queue and takes from the front of it; a worker that runs out
+// steals from the back of the others, so a few expensive items don't leave threads idle
+// The thread that calls run() works as worker 0, so a pool of N only starts N - 1 threads
+//
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int workerCount);
+    ~WorkStealingPool();
+
+    // Call task(worker, item) for every item in [0, itemCount) and wait for all of them
+    void run(int itemCount, const std::function<void(int worker, int item)>& task);
+
+    int workerCount() const { return static_cast<int>(_queues.size()); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<int> items;
+    };
+
+    void workerLoop(int worker);
+    void drain(int worker);
+    bool takeItem(int worker, int& item);
+
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _finished;
+    const std::function<void(int, int)>* _task = nullptr;
+    int _remaining = 0;       // items not finished yet
+    int _busyWorkers = 0;     // helper threads still inside the current batch
+    unsigned _batch = 0;      // bumped for every run() so sleeping workers know there is work
+    bool _quit = false;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// Random keys for Zobrist hashing
+// Generated at compile time from a fixed seed so the same position always hashes the same
+//
+struct ZobristKeys {
+    uint64_t pieces[12][64];
+    uint64_t side;
+    uint64_t castling[16]; // one for each combination of castling rights
+    uint64_t enPassant[8]; // by file of the en passant square
+};
+
+// splitmix64, small and good enough for hash keys
+constexpr uint64_t zobristNext(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys generateZobristKeys()
+{
+    ZobristKeys keys{};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            keys.pieces[piece][square] = zobristNext(state);
+        }
+    }
+    keys.side = zobristNext(state);
+    for (int rights = 0; rights < 16; rights++) {
+        keys.castling[rights] = zobristNext(state);
+    }
+    for (int file = 0; file < 8; file++) {
+        keys.enPassant[file] = zobristNext(state);
+    }
+    return keys;
+}
+
+inline constexpr ZobristKeys Zobrist = generateZobristKeys();
@@ -0,0 +1,12 @@
+// Headless entry point, speaks UCI on stdin/stdout with no window, imgui or OpenGL
+// Build the chess_uci target and point a chess GUI or tournament manager at it
+
+#include "classes/UciInterface.h"
+#include <iostream>
+
+int main(int, char**)
+{
+    UciInterface uci(std::cin, std::cout);
+    uci.loop();
+    return 0;
+}
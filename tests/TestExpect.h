@@ -0,0 +1,23 @@
+#pragma once
+
+//
+// Shared by the tests that go through a list of named checks: each one prints a line
+// starting with ok or FAIL, and main ends with return testResult()
+//
+#include <iostream>
+#include <string>
+
+inline int testFailures = 0;
+
+inline void expect(bool condition, const std::string& what)
+{
+    std::cout << (condition ? "ok    " : "FAIL  ") << what << std::endl;
+    if (!condition) testFailures++;
+}
+
+// Prints the summary and gives the exit code
+inline int testResult()
+{
+    std::cout << (testFailures == 0 ? "all passed" : std::to_string(testFailures) + " failed") << std::endl;
+    return testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+//
+// Perft: counts the leaf nodes of the move generator's tree and compares them against
+// the known counts for a set of standard positions (chessprogramming.org/Perft_Results)
+//
+// usage: chess_perft                      run the suite to each position's test depth, once
+//                                         with every slider attack backend the CPU runs
+//        chess_perft --full               run the suite to every depth with a known count
+//        chess_perft <fen> <depth>        count one position
+//        chess_perft --divide <fen> <depth>
+//
+#include "../classes/ChessEngine.h"
+#include "../classes/MagicBitboards.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct PerftEntry {
+    const char* name;
+    const char* fen;
+    int testDepth;                  // depth the ctest run goes to
+    std::vector<uint64_t> counts;   // known counts for depth 1, 2, 3...
+};
+
+static const std::vector<PerftEntry> perftSuite = {
+    { "start position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+        { 20, 400, 8902, 197281, 4865609, 119060324 } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+        { 48, 2039, 97862, 4085603, 193690690 } },
+    { "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5,
+        { 14, 191, 2812, 43238, 674624, 11030083 } },
+    { "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+        { 6, 264, 9467, 422333, 15833292 } },
+    { "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+        { 44, 1486, 62379, 2103487, 89941194 } },
+    { "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+        { 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int runSuite(ChessEngine& engine, bool full)
+{
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0.0;
+    int failures = 0;
+
+    for (const auto& entry : perftSuite) {
+        Position position;
+        position.setFromFEN(entry.fen);
+
+        const int maxDepth = full ? static_cast<int>(entry.counts.size()) : entry.testDepth;
+        for (int depth = 1; depth <= maxDepth; depth++) {
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t nodes = engine.perft(position, depth);
+            const double seconds = secondsSince(start);
+            const uint64_t expected = entry.counts[depth - 1];
+
+            totalNodes += nodes;
+            totalSeconds += seconds;
+
+            const bool passed = nodes == expected;
+            if (!passed) failures++;
+
+            std::cout << std::left << std::setw(16) << entry.name << std::right
+                << " depth " << depth
+                << std::setw(12) << nodes
+                << (passed ? "  ok  " : "  FAIL expected " + std::to_string(expected) + "  ")
+                << std::fixed << std::setprecision(0) << (seconds > 0.0 ? nodes / seconds : 0.0) << " nodes/s" << std::endl;
+        }
+    }
+
+    std::cout << "total " << totalNodes << " nodes in " << std::setprecision(3) << totalSeconds << "s, "
+        << std::setprecision(0) << (totalSeconds > 0.0 ? totalNodes / totalSeconds : 0.0) << " nodes/s" << std::endl;
+    std::cout << failures << " failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    ChessEngine engine;
+
+    if (argc == 1) {
+        int result = 0;
+        for (SliderBackend backend : { SLIDER_MAGIC, SLIDER_PEXT }) {
+            if (!setSliderBackend(backend)) {
+                std::cout << sliderBackendName(backend) << " not supported" << std::endl;
+                continue;
+            }
+            std::cout << sliderBackendName(backend) << " slider attacks" << std::endl;
+            result |= runSuite(engine, false);
+        }
+        return result;
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--full") == 0) {
+        return runSuite(engine, true);
+    }
+
+    const bool divide = std::strcmp(argv[1], "--divide") == 0;
+    const int fenArg = divide ? 2 : 1;
+    if (argc < fenArg + 2) {
+        std::cerr << "usage: chess_perft [--full] | [--divide] <fen> <depth>" << std::endl;
+        return 2;
+    }
+
+    Position position;
+    if (!position.setFromFEN(argv[fenArg])) {
+        std::cerr << "bad fen: " << argv[fenArg] << std::endl;
+        return 2;
+    }
+    const int depth = std::atoi(argv[fenArg + 1]);
+
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    if (divide) {
+        for (const auto& [move, count] : engine.divide(position, depth)) {
+            std::cout << moveToString(move) << ": " << count << std::endl;
+            nodes += count;
+        }
+    }
+    else {
+        nodes = engine.perft(position, depth);
+    }
+    const double seconds = secondsSince(start);
+
+    std::cout << "nodes " << nodes << " in " << std::setprecision(3) << seconds << "s, "
+        << std::fixed << std::setprecision(0) << (seconds > 0.0 ? nodes / seconds : 0.0) << " nodes/s" << std::endl;
+    return 0;
+}
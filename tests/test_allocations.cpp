@@ -0,0 +1,57 @@
+//
+// Counts heap allocations made while the engine searches
+// The first search is allowed to allocate its thread buffers; every search after that
+// with the same settings should not touch the heap at all
+//
+#include "../classes/ChessEngine.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+static std::atomic<long long> allocationCount{ 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static const char* testPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 b",
+};
+
+int main()
+{
+    ChessEngine engine;
+    engine.setThreadCount(1);
+
+    SearchLimits limits;
+    limits.maxDepth = 5;
+
+    Position position;
+    position.setFromFEN(testPositions[0]);
+    engine.search(position, limits); // warm up
+
+    bool passed = true;
+    for (const char* fen : testPositions) {
+        position.setFromFEN(fen);
+
+        const long long before = allocationCount;
+        SearchResult result = engine.search(position, limits);
+        const long long allocations = allocationCount - before;
+
+        std::cout << fen << ": " << result.nodes << " nodes, " << allocations << " allocations" << std::endl;
+        if (allocations != 0) {
+            passed = false;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+//
+// Checks the full bitboard evaluation against the score Position keeps up to date in
+// makeMove/unmakeMove, for every backend the CPU can run, at every node of a shallow tree
+//
+#include "../classes/BitboardEvaluator.h"
+#include "../classes/ChessEngine.h"
+#include "../classes/Evaluation.h"
+#include <iostream>
+
+static const char* testPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+};
+
+static const EvalBackend backends[] = { EVAL_SCALAR, EVAL_SSE41, EVAL_AVX2, EVAL_BEST };
+
+static long long mismatches = 0;
+static long long positionsChecked = 0;
+
+static void check(const ChessEngine& engine, const Position& position)
+{
+    positionsChecked++;
+    const int expected = engine.evaluateBoard(position);
+    for (EvalBackend backend : backends) {
+        if (!evalBackendSupported(backend)) continue;
+
+        const EvalScores scores = evaluateBitboards(position.bitboards, backend);
+        const bool same = scores.middlegame == position.middlegame && scores.endgame == position.endgame &&
+            scores.phase == position.phase && taperedScore(scores.middlegame, scores.endgame, scores.phase) == expected;
+        if (!same && mismatches++ < 10) {
+            std::cout << evalBackendName(backend) << " mismatch: middlegame " << scores.middlegame << "/" << position.middlegame
+                << " endgame " << scores.endgame << "/" << position.endgame
+                << " phase " << scores.phase << "/" << position.phase << std::endl;
+        }
+    }
+}
+
+static void walk(ChessEngine& engine, Position& position, int depth)
+{
+    check(engine, position);
+    if (depth == 0) return;
+
+    MoveList moves;
+    engine.generateAllMoves(position, position.sideToMove, moves);
+    for (const BitMove& move : moves) {
+        UndoInfo undo;
+        position.makeMove(move, undo);
+        walk(engine, position, depth - 1);
+        position.unmakeMove(move, undo);
+    }
+}
+
+int main()
+{
+    ChessEngine engine;
+
+    for (EvalBackend backend : backends) {
+        std::cout << evalBackendName(backend) << (evalBackendSupported(backend) ? " supported" : " not supported") << std::endl;
+    }
+
+    for (const char* fen : testPositions) {
+        Position position;
+        position.setFromFEN(fen);
+        walk(engine, position, 3);
+    }
+
+    std::cout << positionsChecked << " positions, " << mismatches << " mismatches" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
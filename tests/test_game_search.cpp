@@ -0,0 +1,105 @@
+//
+// Checks what the engine keeps between the searches of a game: the hash table, history,
+// killers and the expected reply. Playing a game with one engine has to choose the same
+// moves as a fresh engine searching each position to the same depth, newGame has to
+// leave nothing behind that changes the tree, and the table's 3 bit search counter
+// wrapping round after 8 searches mustn't spoil what it holds
+//
+#include "../classes/ChessEngine.h"
+#include "TestExpect.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char* gamePositions[] = {
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+};
+
+static constexpr int GAME_DEPTH = 5;
+static constexpr int GAME_PLIES = 12;  // more searches than the table's counter holds
+
+static SearchResult searchTo(ChessEngine& engine, const Position& position, int depth, const std::vector<uint64_t>& history = {})
+{
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    return engine.search(position, limits, history);
+}
+
+// Plays the game out with one engine, checking every move against a fresh one
+static void playGame(const char* fen)
+{
+    ChessEngine engine;
+    Position position;
+    position.setFromFEN(fen);
+    std::vector<uint64_t> history;
+
+    int plies = 0;
+    for (; plies < GAME_PLIES; plies++) {
+        const SearchResult kept = searchTo(engine, position, GAME_DEPTH, history);
+        ChessEngine freshEngine;
+        const SearchResult fresh = searchTo(freshEngine, position, GAME_DEPTH, history);
+        expect(kept.bestMove == fresh.bestMove, std::string(fen) + " ply " + std::to_string(plies) + ": " +
+            moveToString(kept.bestMove) + " kept, " + moveToString(fresh.bestMove) + " fresh");
+        if (kept.bestMove.isNone()) break;
+
+        UndoInfo undo;
+        history.push_back(position.hash);
+        position.makeMove(kept.bestMove, undo);
+    }
+    std::cout << "game of " << plies << " plies from " << fen << std::endl;
+}
+
+// A search after newGame has to be the one a new engine would make, node for node, even
+// in the position two plies down the last search's line where it expects to be next
+static void newGameForgets()
+{
+    ChessEngine engine;
+    Position first;
+    first.setFromFEN(gamePositions[0]);
+    Position position;
+    position.setFromFEN(gamePositions[1]);
+
+    searchTo(engine, first, GAME_DEPTH);
+    const SearchResult before = searchTo(engine, position, GAME_DEPTH);
+    for (int i = 0; i < 2 && i < before.pvLength; i++) {
+        UndoInfo undo;
+        position.makeMove(before.pv[i], undo);
+    }
+    engine.newGame();
+    const SearchResult afterNewGame = searchTo(engine, position, GAME_DEPTH);
+
+    ChessEngine freshEngine;
+    const SearchResult fresh = searchTo(freshEngine, position, GAME_DEPTH);
+    expect(afterNewGame.nodes == fresh.nodes && afterNewGame.bestMove == fresh.bestMove && afterNewGame.score == fresh.score,
+        "after newGame " + std::to_string(afterNewGame.nodes) + " nodes, fresh " + std::to_string(fresh.nodes));
+}
+
+// Searching the same mate over and over takes the counter round more than once, every
+// search still has to find it at the right distance
+static void generationWraps()
+{
+    ChessEngine engine;
+    Position position;
+    position.setFromFEN("r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1");
+    for (int search = 0; search < 20; search++) {
+        // Shallower searches can only know the mate from the table
+        const int depth = 2 + search % 5;
+        const SearchResult result = searchTo(engine, position, depth);
+        expect(depth < 5 || (result.score == MATE_SCORE - 5 && moveToString(result.bestMove) == "f6a6"),
+            "search " + std::to_string(search) + ": " + std::to_string(result.score) + " " + moveToString(result.bestMove));
+        expect(result.score <= MATE_SCORE - 5, "search " + std::to_string(search) + " found a mate shorter than 3: " + std::to_string(result.score));
+    }
+    std::cout << "20 searches of a mate in 3 with one table" << std::endl;
+}
+
+int main()
+{
+    for (const char* fen : gamePositions) {
+        playGame(fen);
+    }
+    newGameForgets();
+    generationWraps();
+
+    return testResult();
+}
@@ -0,0 +1,76 @@
+//
+// Checks the search's mate and draw scores on known positions: mate in N is worth
+// MATE_SCORE - (2N - 1) with the mating move first, stalemate is a draw with no move,
+// a mate score read back from the hash table at another ply still counts from the root,
+// and mate on the hundredth ply beats the fifty move rule
+//
+#include "../classes/ChessEngine.h"
+#include "TestExpect.h"
+#include <string>
+
+static int mateIn(int moves)
+{
+    return MATE_SCORE - (2 * moves - 1);
+}
+
+static SearchResult searchFen(ChessEngine& engine, const char* fen, int depth)
+{
+    Position position;
+    position.setFromFEN(fen);
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    return engine.search(position, limits);
+}
+
+static void expectMate(ChessEngine& engine, const char* name, const char* fen, int moves, const char* firstMove)
+{
+    engine.newGame();
+    const SearchResult result = searchFen(engine, fen, 2 * moves + 2);
+    expect(result.score == mateIn(moves) && moveToString(result.bestMove) == firstMove,
+        std::string(name) + ": " + std::to_string(result.score) + " " + moveToString(result.bestMove));
+}
+
+int main()
+{
+    ChessEngine engine;
+
+    expectMate(engine, "back rank mate in 1", "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1", 1, "a1a8");
+    expectMate(engine, "mate in 3", "r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1", 3, "f6a6");
+
+    engine.newGame();
+    const SearchResult stalemate = searchFen(engine, "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", 6);
+    expect(stalemate.score == DRAW_SCORE && stalemate.bestMove.isNone(), "stalemate is a draw with no move");
+
+    // The mate in 3 after f6a6 f7f6 is a mate in 2, which the first search stored two plies
+    // below the root. The table keeps it counted from that node, and reading it back at
+    // the root of the next search, or the other way round, still gives the right distance
+    const char* mateIn3 = "r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1";
+    const char* mateIn2 = "r5rk/7p/R4p2/4B3/8/8/7P/7K w - - 0 2";
+    engine.newGame();
+    searchFen(engine, mateIn3, 8);
+    Position child;
+    child.setFromFEN(mateIn2);
+    TTData entry{};
+    const bool stored = engine.transpositionTable().probe(child.hash, entry);
+    expect(stored && entry.score == mateIn(2), "table holds the mate in 2 counted from its node: " + std::to_string(entry.score));
+    SearchResult result = searchFen(engine, mateIn2, 4);
+    expect(result.score == mateIn(2) && moveToString(result.bestMove) == "e5f6",
+        "mate in 2 from the mate in 3's table: " + std::to_string(result.score));
+    engine.newGame();
+    searchFen(engine, mateIn2, 6);
+    result = searchFen(engine, mateIn3, 6);
+    expect(result.score == mateIn(3) && moveToString(result.bestMove) == "f6a6",
+        "mate in 3 from the mate in 2's table: " + std::to_string(result.score));
+
+    // Ra8 is the hundredth ply without a capture or pawn move. Mate still wins, but a check
+    // that can be escaped is a draw like every other move
+    engine.newGame();
+    result = searchFen(engine, "6k1/5ppp/8/8/8/8/8/R5K1 w - - 99 80", 4);
+    expect(result.score == mateIn(1) && moveToString(result.bestMove) == "a1a8",
+        "mate on the hundredth ply: " + std::to_string(result.score));
+    engine.newGame();
+    result = searchFen(engine, "6k1/6pp/8/8/8/8/8/R5K1 w - - 99 80", 4);
+    expect(result.score == DRAW_SCORE, "escapable check on the hundredth ply: " + std::to_string(result.score));
+
+    return testResult();
+}
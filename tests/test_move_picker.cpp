@@ -0,0 +1,130 @@
+//
+// Checks the two things the search's staged move picker relies on, at every node of a
+// shallow tree from the perft positions:
+//  - isLegal, which guards the hash table move and the killers, accepts exactly the
+//    generated moves out of every from square, to square and flag combination
+//  - the picker hands out every legal move exactly once, whatever hash move and
+//    killers it is given, legal here or left over from another position
+//
+#include "../classes/ChessEngine.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+static const char* testPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+static long long nodes = 0;
+static long long probes = 0;
+static long long failures = 0;
+
+// Moves from other positions, to offer the picker as stale hash moves and killers
+static std::vector<BitMove> foreignMoves;
+static std::vector<BitMove> foreignQuiets;
+
+static void fail(const Position& position, const char* what, const BitMove& move)
+{
+    if (failures++ < 10) {
+        std::cout << what << " " << moveToString(move) << " flags " << move.flags()
+            << " with " << (position.sideToMove == WHITE ? "white" : "black") << " to move" << std::endl;
+    }
+}
+
+static void checkLegality(const ChessEngine& engine, const Position& position, const MoveList& moves)
+{
+    std::vector<bool> generated(1 << 16, false);
+    for (const BitMove& move : moves) generated[move.data] = true;
+
+    for (int data = 0; data < (1 << 16); data++) {
+        BitMove move;
+        move.data = static_cast<uint16_t>(data);
+        probes++;
+        if (engine.isLegal(position, move) != generated[data]) {
+            fail(position, generated[data] ? "isLegal rejects" : "isLegal accepts", move);
+        }
+    }
+}
+
+static void checkPicker(const ChessEngine& engine, const Position& position, const MoveList& moves, int ply)
+{
+    std::vector<BitMove> quiets;
+    for (const BitMove& move : moves) {
+        if (!move.isCapture() && !move.isPromotion()) quiets.push_back(move);
+    }
+
+    const size_t count = foreignMoves.size();
+    const size_t quietCount = foreignQuiets.size();
+    for (int round = 0; round < 4; round++) {
+        // Legal hash move or killers on some rounds, leftovers from elsewhere on others
+        BitMove ttMove;
+        if (round & 1) ttMove = moves.empty() ? BitMove() : moves[(ply + round) % moves.size()];
+        else if (count) ttMove = foreignMoves[(nodes * 7 + round) % count];
+
+        // Killers go in the way a cutoff stores them, so they are quiet and never the same
+        MoveOrdering ordering;
+        if (quietCount) {
+            const BitMove older = foreignQuiets[(nodes * 31 + round) % quietCount];
+            const BitMove newer = round & 2 || quiets.empty() ? foreignQuiets[(nodes * 13) % quietCount] : quiets.back();
+            ordering.cutoff(position, older, 1, ply, 1, MoveList());
+            ordering.cutoff(position, newer, 1, ply, 1, MoveList());
+        }
+
+        MoveList picked;
+        engine.pickedMoves(position, ordering, ttMove, ply, picked);
+
+        std::vector<uint16_t> expected, got;
+        for (const BitMove& move : moves) expected.push_back(move.data);
+        for (const BitMove& move : picked) got.push_back(move.data);
+        std::sort(expected.begin(), expected.end());
+        std::sort(got.begin(), got.end());
+        if (expected != got) {
+            fail(position, "picker moves differ from the generator's, hash move", ttMove);
+        }
+        else if (!ttMove.isNone() && engine.isLegal(position, ttMove) && !(picked[0] == ttMove)) {
+            fail(position, "picker didn't start with the hash move", ttMove);
+        }
+    }
+}
+
+static void walk(ChessEngine& engine, Position& position, int depth, int ply)
+{
+    nodes++;
+    MoveList moves;
+    engine.generateAllMoves(position, position.sideToMove, moves);
+
+    checkLegality(engine, position, moves);
+    checkPicker(engine, position, moves, ply);
+    if (foreignMoves.size() < 4096) {
+        foreignMoves.insert(foreignMoves.end(), moves.begin(), moves.end());
+        for (const BitMove& move : moves) {
+            if (!move.isCapture() && !move.isPromotion()) foreignQuiets.push_back(move);
+        }
+    }
+
+    if (depth == 0) return;
+    for (const BitMove& move : moves) {
+        UndoInfo undo;
+        position.makeMove(move, undo);
+        walk(engine, position, depth - 1, ply + 1);
+        position.unmakeMove(move, undo);
+    }
+}
+
+int main()
+{
+    ChessEngine engine;
+    for (const char* fen : testPositions) {
+        Position position;
+        position.setFromFEN(fen);
+        walk(engine, position, 2, 0);
+    }
+
+    std::cout << nodes << " positions, " << probes << " isLegal probes, " << failures << " failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
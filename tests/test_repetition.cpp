@@ -0,0 +1,113 @@
+//
+// Checks repetition detection: isRepetition on a knight shuffle from the start position,
+// and a search that can only save itself with perpetual check, which has to see the draw
+// the game's earlier moves make of it, and a search given more history than the fifty
+// move rule can use
+//
+#include "../classes/ChessEngine.h"
+#include "TestExpect.h"
+#include <string>
+#include <vector>
+
+// Plays a move given as "g1f3", keeping the key of the position it leaves
+static void play(const ChessEngine& engine, Position& position, std::vector<uint64_t>& keys, const std::string& name)
+{
+    MoveList moves;
+    engine.generateAllMoves(position, position.sideToMove, moves);
+    for (const BitMove& move : moves) {
+        if (moveToString(move) == name) {
+            UndoInfo undo;
+            keys.push_back(position.hash);
+            position.makeMove(move, undo);
+            return;
+        }
+    }
+    expect(false, "no move " + name);
+}
+
+static void playAll(const ChessEngine& engine, Position& position, std::vector<uint64_t>& keys, const std::vector<std::string>& names)
+{
+    for (const std::string& name : names) play(engine, position, keys, name);
+}
+
+static const std::vector<std::string> knightShuffle = { "g1f3", "g8f6", "f3g1", "f6g8" };
+
+static void knightShuffles(const ChessEngine& engine)
+{
+    Position position;
+    position.setFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    std::vector<uint64_t> keys;
+
+    playAll(engine, position, keys, knightShuffle);
+    const int count = static_cast<int>(keys.size());
+    expect(!isRepetition(position, keys.data(), count), "second occurrence is not a game repetition");
+    expect(isRepetition(position, keys.data(), count, 4), "second occurrence inside the search path is a draw");
+    expect(!isRepetition(position, keys.data(), count, 3), "the earlier occurrence has to be on the search path");
+
+    playAll(engine, position, keys, knightShuffle);
+    expect(isRepetition(position, keys.data(), static_cast<int>(keys.size())), "third occurrence is a repetition");
+
+    // A capture or pawn move in between means nothing before it can match again, which
+    // the halfmove clock tells isRepetition without looking at the keys
+    Position reset = position;
+    reset.halfmoveClock = 0;
+    expect(!isRepetition(reset, keys.data(), static_cast<int>(keys.size())), "reset halfmove clock is not a repetition");
+
+    play(engine, position, keys, "e2e4");
+    playAll(engine, position, keys, { "g8f6", "g1f3", "f6g8", "f3g1" });
+    expect(!isRepetition(position, keys.data(), static_cast<int>(keys.size())), "shuffle after a pawn move starts counting again");
+    playAll(engine, position, keys, { "g8f6", "g1f3", "f6g8", "f3g1" });
+    expect(isRepetition(position, keys.data(), static_cast<int>(keys.size())), "and again is a game repetition");
+    expect(position.halfmoveClock == 8, "pawn move resets the halfmove clock");
+}
+
+static void perpetualCheck(ChessEngine& engine)
+{
+    // Black is a rook up and threatens Qa1 mate, white's only hope is to
+    // keep checking with Qe8+ Kh7 Qh5+ Kg8
+    const char* fen = "6k1/6p1/8/7Q/8/8/qr6/7K w - - 0 1";
+    const std::vector<std::string> cycle = { "h5e8", "g8h7", "e8h5", "h7g8" };
+
+    SearchLimits limits;
+    limits.maxDepth = 3;
+
+    // Without the game's moves three plies is too short to see the checks repeat
+    Position position;
+    position.setFromFEN(fen);
+    engine.newGame();
+    const SearchResult fresh = engine.search(position, limits);
+    expect(fresh.score < -500, "perpetual check out of reach without history");
+
+    // After the cycle has been played twice the first check repeats the position a third time
+    std::vector<uint64_t> history;
+    playAll(engine, position, history, cycle);
+    playAll(engine, position, history, cycle);
+    engine.newGame();
+    const SearchResult repeated = engine.search(position, limits, history);
+    expect(repeated.score == DRAW_SCORE, "search with history scores the repetition line as a draw");
+    expect(moveToString(repeated.bestMove) == "h5e8", "search with history takes the perpetual");
+}
+
+static void longHistory(ChessEngine& engine)
+{
+    // The clock can say far more than the fifty move window, only the last 100 keys matter
+    Position position;
+    position.setFromFEN("6k1/6p1/8/7Q/8/8/qr6/7K w - - 900 500");
+    const std::vector<uint64_t> history(900, position.hash ^ 1);
+
+    SearchLimits limits;
+    limits.maxDepth = 3;
+    engine.newGame();
+    const SearchResult result = engine.search(position, limits, history);
+    expect(result.score == DRAW_SCORE && !result.bestMove.isNone(), "long history past the fifty move rule is a draw");
+}
+
+int main()
+{
+    ChessEngine engine;
+    knightShuffles(engine);
+    perpetualCheck(engine);
+    longHistory(engine);
+
+    return testResult();
+}
@@ -0,0 +1,121 @@
+//
+// Drives the UCI front end with a scripted session and checks that it answers the
+// handshake and plays a legal move from a position reached through a move list
+// Then checks that "go infinite" reports its iterations as it goes but holds the move
+// back until "stop", even when the search runs out of depth on its own
+//
+#include "../classes/UciInterface.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// The search thread writes while the test reads, so both go through a lock
+class LockedBuffer : public std::stringbuf {
+public:
+    std::string snapshot()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return str();
+    }
+
+protected:
+    std::streamsize xsputn(const char* s, std::streamsize count) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return std::stringbuf::xsputn(s, count);
+    }
+    int_type overflow(int_type ch) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return std::stringbuf::overflow(ch);
+    }
+
+private:
+    std::recursive_mutex _mutex; // xsputn calls overflow when the buffer fills
+};
+
+// Polls the output until the text turns up, false if it hasn't within the timeout
+static bool waitFor(LockedBuffer& buffer, const std::string& text, std::chrono::seconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (buffer.snapshot().find(text) == std::string::npos) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static bool infiniteWaitsForStop()
+{
+    LockedBuffer buffer;
+    std::ostream output(&buffer);
+    std::istringstream input;
+    UciInterface uci(input, output);
+
+    // Mate in one, every iteration is over almost at once, so the search soon reaches its
+    // last depth and has nothing left to do but wait. A move sent without a stop would
+    // follow straight after the last info line, so allow it a moment to show up
+    uci.command("position fen 6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    uci.command("go infinite");
+    const bool reported = waitFor(buffer, "info depth 1 ", std::chrono::seconds(30)) &&
+        waitFor(buffer, "info depth " + std::to_string(MAX_DEPTH) + " ", std::chrono::seconds(30));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const std::string before = buffer.snapshot();
+    uci.command("stop");
+    const std::string after = buffer.snapshot();
+    std::cout << after;
+
+    const bool held = before.find("bestmove") == std::string::npos;
+    const bool sent = after.find("bestmove a1a8") != std::string::npos;
+    std::cout << "infinite: " << (reported ? "" : "no info, ") << (held ? "" : "bestmove before stop, ")
+        << (sent ? "" : "no bestmove after stop, ") << "done" << std::endl;
+    return reported && held && sent;
+}
+
+int main()
+{
+    std::istringstream input(
+        "uci\n"
+        "setoption name Hash value 8\n"
+        "setoption name Threads value 2\n"
+        "isready\n"
+        "ucinewgame\n"
+        "position startpos moves e2e4 e7e5 g1f3 b8c6 f1c4 g8f6\n"
+        "go depth 4\n");
+    std::ostringstream output;
+
+    {
+        UciInterface uci(input, output);
+        uci.loop();
+    }
+
+    const std::string reply = output.str();
+    std::cout << reply;
+
+    bool passed = reply.find("uciok") != std::string::npos && reply.find("readyok") != std::string::npos;
+
+    // The move has to be one of white's legal moves after the moves above
+    Position position;
+    position.setFromFEN("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+    ChessEngine engine;
+    MoveList moves;
+    engine.generateAllMoves(position, position.sideToMove, moves);
+
+    const size_t bestMoveAt = reply.find("bestmove ");
+    bool legal = false;
+    if (bestMoveAt != std::string::npos) {
+        std::istringstream line(reply.substr(bestMoveAt + 9));
+        std::string bestMove;
+        line >> bestMove;
+        for (auto move : moves) {
+            legal = legal || moveToString(move) == bestMove;
+        }
+    }
+    passed = passed && legal && infiniteWaitsForStop();
+
+    std::cout << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+//
+// Magic number generator
+// Finds a "black magic" for every rook and bishop square, then packs all 128 tables into one
+// array where the tables overlap. A black magic multiplies the blockers with every square
+// outside the mask set, so a good one leaves many of its table's slots unused, and another
+// square's table can use them instead. Each square gets an offset into the shared array
+// instead of a slice of its own, and MagicBitboards.h fills the array in at compile time
+// (and refuses to compile if two tables ever want different attack sets in one slot).
+//
+// Out of the candidates it tries for each square it keeps the valid magic whose used slots
+// span the shortest stretch of its table, then the one using the fewest of them. The free
+// slots on either side and in between are where the other tables go. More candidates make a smaller table and a slower run.
+//
+// usage: chess_magic_gen [output header] [candidates per square] [seed]
+//        writes classes/MagicTables.h by default
+//
+#define MAGIC_GENERATOR
+#include "../classes/MagicBitboards.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SquareMagic {
+    uint64_t magic = 0;
+    int shift = 0;
+    int offset = 0;
+    std::vector<int> indexes;       // slots the magic uses
+    std::vector<uint64_t> attacks;  // attack set for each used slot
+};
+
+struct Occupancies {
+    std::vector<uint64_t> keys;     // blockers with every square outside the mask set
+    std::vector<uint64_t> attacks;
+};
+
+static Occupancies enumerate(int square, bool rook)
+{
+    Occupancies occupancies;
+    const uint64_t mask = rook ? RMasks[square] : BMasks[square];
+    uint64_t subset = 0;
+    do {
+        occupancies.keys.push_back(subset | ~mask);
+        occupancies.attacks.push_back(sliderAttacks(square, rook, subset));
+        subset = (subset - mask) & mask;
+    } while (subset);
+    return occupancies;
+}
+
+// Sparse candidates make far better magics than uniformly random ones
+static uint64_t randomCandidate(std::mt19937_64& rng)
+{
+    return rng() & rng() & rng();
+}
+
+// Fills slots with the attack set for each index, false on a destructive collision
+// span is how many slots there are from the first used one to the last
+static bool tryMagic(const Occupancies& occupancies, uint64_t magic, int shift, std::vector<uint64_t>& slots, int& span, int& used)
+{
+    used = 0;
+    std::fill(slots.begin(), slots.end(), 0);
+    size_t first = slots.size();
+    size_t last = 0;
+    for (size_t i = 0; i < occupancies.keys.size(); i++) {
+        const size_t index = static_cast<size_t>((occupancies.keys[i] * magic) >> shift);
+        if (slots[index] == 0) {
+            slots[index] = occupancies.attacks[i];
+            used++;
+            first = std::min(first, index);
+            last = std::max(last, index);
+        }
+        else if (slots[index] != occupancies.attacks[i]) {
+            return false;
+        }
+    }
+    span = static_cast<int>(last - first + 1);
+    return true;
+}
+
+static SquareMagic findMagic(int square, bool rook, int candidates, std::mt19937_64& rng)
+{
+    const Occupancies occupancies = enumerate(square, rook);
+    const int bits = rook ? countOnes(RMasks[square]) : countOnes(BMasks[square]);
+    const int shift = 64 - bits;
+
+    std::vector<uint64_t> slots(static_cast<size_t>(1) << bits);
+    SquareMagic best;
+    int bestSpan = 1 << 30;
+    int bestUsed = 1 << 30;
+    for (int tried = 0; tried < candidates || best.magic == 0; tried++) {
+        const uint64_t magic = randomCandidate(rng);
+        int span, used;
+        if (!tryMagic(occupancies, magic, shift, slots, span, used)) continue;
+        if (span > bestSpan || (span == bestSpan && used >= bestUsed)) continue;
+
+        bestSpan = span;
+        bestUsed = used;
+        best.magic = magic;
+        best.shift = shift;
+        best.indexes.clear();
+        best.attacks.clear();
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i] != 0) {
+                best.indexes.push_back(static_cast<int>(i));
+                best.attacks.push_back(slots[i]);
+            }
+        }
+    }
+    return best;
+}
+
+// First fit, biggest tables first. A slider always attacks something, so 0 marks a free
+// slot, and two tables can meet on free slots or where they want the same attack set
+static int pack(std::vector<SquareMagic*>& order)
+{
+    std::sort(order.begin(), order.end(), [](const SquareMagic* a, const SquareMagic* b) {
+        return a->indexes.size() > b->indexes.size();
+    });
+
+    std::vector<uint64_t> table;
+    for (SquareMagic* square : order) {
+        for (int offset = 0;; offset++) {
+            bool fits = true;
+            for (size_t i = 0; i < square->indexes.size() && fits; i++) {
+                const size_t slot = static_cast<size_t>(offset) + square->indexes[i];
+                fits = slot >= table.size() || table[slot] == 0 || table[slot] == square->attacks[i];
+            }
+            if (!fits) continue;
+
+            square->offset = offset;
+            for (size_t i = 0; i < square->indexes.size(); i++) {
+                const size_t slot = static_cast<size_t>(offset) + square->indexes[i];
+                if (slot >= table.size()) table.resize(slot + 1, 0);
+                table[slot] = square->attacks[i];
+            }
+            break;
+        }
+    }
+    return static_cast<int>(table.size());
+}
+
+static void writeArray(std::ostream& out, const char* comment, const char* type, const char* name, const SquareMagic* squares, int SquareMagic::*field)
+{
+    out << "// " << comment << "\n";
+    out << "constexpr " << type << " " << name << "[64] = {\n";
+    for (int square = 0; square < 64; square++) {
+        out << "  " << squares[square].*field << ",\n";
+    }
+    out << "};\n\n";
+}
+
+static void writeMagics(std::ostream& out, const char* comment, const char* name, const SquareMagic* squares)
+{
+    out << "// " << comment << "\n";
+    out << "constexpr uint64_t " << name << "[64] = {\n";
+    for (int square = 0; square < 64; square++) {
+        out << "  0x" << std::hex << std::setw(16) << std::setfill('0') << squares[square].magic << std::dec << "ULL,\n";
+    }
+    out << "};\n\n";
+}
+
+int main(int argc, char** argv)
+{
+    const std::string outputPath = argc > 1 ? argv[1] : "classes/MagicTables.h";
+    const int candidates = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000000;
+    const uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20240601;
+
+    std::mt19937_64 rng(seed);
+    SquareMagic rooks[64];
+    SquareMagic bishops[64];
+    std::vector<SquareMagic*> order;
+    int plainSize = 0;
+    for (int square = 0; square < 64; square++) {
+        rooks[square] = findMagic(square, true, candidates, rng);
+        bishops[square] = findMagic(square, false, candidates, rng);
+        order.push_back(&rooks[square]);
+        order.push_back(&bishops[square]);
+        plainSize += RAttackSize[square] + BAttackSize[square];
+    }
+
+    const int tableSize = pack(order);
+    std::cout << "one slice per square " << plainSize << " entries (" << plainSize * 8 / 1024 << " KB), shared "
+        << tableSize << " entries (" << tableSize * 8 / 1024 << " KB)" << std::endl;
+
+    std::ostringstream out;
+    out << "//\n"
+        << "// Generated by chess_magic_gen (tools/magic_gen.cpp) with " << candidates << " candidates per square\n"
+        << "// and seed " << seed << ", don't edit by hand. The rook and bishop tables overlap in one\n"
+        << "// array of SliderAttackTableSize entries, each square's index is added to its offset.\n"
+        << "//\n"
+        << "#ifndef MAGIC_TABLES_H\n"
+        << "#define MAGIC_TABLES_H\n\n"
+        << "#include <stdint.h>\n\n"
+        << "constexpr int SliderAttackTableSize = " << tableSize << ";\n\n";
+    writeArray(out, "Magic bitboard shift amounts", "int", "RShifts", rooks, &SquareMagic::shift);
+    writeArray(out, "Where each square's rook table starts in the shared array", "int", "RAttackOffset", rooks, &SquareMagic::offset);
+    writeMagics(out, "Magic numbers for rooks", "RMagic", rooks);
+    writeArray(out, "Magic bitboard shift amounts", "int", "BShifts", bishops, &SquareMagic::shift);
+    writeArray(out, "Where each square's bishop table starts in the shared array", "int", "BAttackOffset", bishops, &SquareMagic::offset);
+    writeMagics(out, "Magic numbers for bishops", "BMagic", bishops);
+    out << "#endif // MAGIC_TABLES_H\n";
+
+    std::ofstream file(outputPath);
+    if (!file) {
+        std::cerr << "can't write " << outputPath << std::endl;
+        return 1;
+    }
+    file << out.str();
+    std::cout << "wrote " << outputPath << std::endl;
+    return 0;
+}